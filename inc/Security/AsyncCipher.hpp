@@ -0,0 +1,111 @@
+#ifndef SECURITY_ASYNCCIPHER_HPP
+#define SECURITY_ASYNCCIPHER_HPP
+
+#include "Key.hpp"
+#include <Stream/Transform.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace Security {
+
+/**
+ * @brief	Stream::Output %Cipher encryptor running on its own thread
+ * @details	Written data is collected in one of two buffers, a full buffer is encrypted by a worker thread while the
+ * 			other one is being filled. The writing thread passes the ciphertext of a buffer to the sink when it submits
+ * 			the next one, so the sink is written while the worker encrypts. Output is identical to CipherEncrypt with
+ * 			the same cipher.
+ * 			An exception thrown on the worker thread is rethrown by the next write, flush or finalization.
+ * @class	AsyncCipherEncrypt AsyncCipher.hpp "Security/AsyncCipher.hpp"
+ */
+class AsyncCipherEncrypt : public Stream::TransformOutput {
+	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> mCtx{nullptr, EVP_CIPHER_CTX_free};
+	std::unique_ptr<std::byte[]> mBuffers[2];
+	std::unique_ptr<std::byte[]> mOutputs[2];
+	std::size_t mBufferSize = 0;
+	std::size_t mFill = 0;
+	int mCurrent = 0;
+	std::size_t mSubmitted = 0;
+	std::size_t mEncrypted = 0;
+	int mExtSize = 0;
+	int mTagSize = 0;
+	bool mBusy = false;
+	bool mStop = false;
+	bool mFinalized = false;
+	std::exception_ptr mError;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::thread mWorker;
+	clockid_t mWorkerClock{};
+
+	std::size_t
+	writeBytes(std::byte const* src, std::size_t size) override;
+
+	void
+	work();
+
+	void
+	forward(std::byte const* src, std::size_t size);
+
+	void
+	submit();
+
+	void
+	wait();
+
+	void
+	drain();
+
+public:
+	struct Exception : Stream::Output::Exception
+	{ using Stream::Output::Exception::Exception; };
+
+	/**
+	 * @param	cipher Cipher
+	 * @param	key Secret key
+	 * @param	iv Initialization vector
+	 * @param	bufferSize Size of each of the two buffers
+	 */
+	AsyncCipherEncrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+			std::size_t bufferSize = 256*1024);
+
+	AsyncCipherEncrypt(AsyncCipherEncrypt const&) = delete;
+
+	AsyncCipherEncrypt&
+	operator=(AsyncCipherEncrypt const&) = delete;
+
+	~AsyncCipherEncrypt();
+
+	/**
+	 * @brief	Encrypt the collected data, wait for the worker and flush the sink
+	 */
+	Stream::Output&
+	flush() override;
+
+	/**
+	 * @brief	Feed additional authenticated data of an AEAD cipher
+	 * @details	Must be called before any data is written, not supported by non AEAD ciphers.
+	 */
+	void
+	updateAAD(void const* aad, std::size_t size);
+
+	/**
+	 * @brief	Encrypt the collected data, wait for the worker and finalize encryption
+	 * @details	For AEAD ciphers the tag is appended to the output.
+	 */
+	void
+	finalizeEncryption();
+
+	/**
+	 * @return	CPU time consumed by the worker thread
+	 */
+	[[nodiscard]] std::chrono::nanoseconds
+	getWorkerCpuTime() const;
+};//class Security::AsyncCipherEncrypt
+
+}//namespace Security
+
+#endif //SECURITY_ASYNCCIPHER_HPP
@@ -0,0 +1,189 @@
+#ifndef SECURITY_CHECKPOINT_HPP
+#define SECURITY_CHECKPOINT_HPP
+
+#include "Signer.hpp"
+#include <Stream/Transform.hpp>
+#include <chrono>
+#include <optional>
+
+namespace Security {
+
+/**
+ * @brief	Stream::Input signed checkpoint verifier
+ * @details	Data is released only after the checkpoint following it is verified, at most the interval of the stream is
+ * 			kept in memory.
+ * @see		Checkpoint for the stream format
+ * @class	CheckpointInput Checkpoint.hpp "Security/Checkpoint.hpp"
+ */
+class CheckpointInput : public Stream::TransformInput {
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	std::optional<Verifier> mVerifier;
+	std::unique_ptr<std::byte[]> mData;
+	std::byte* mPlainCurr = nullptr;
+	std::byte const* mPlainEnd = nullptr;
+	std::uint32_t mInterval = 0;
+	std::uint32_t mMaxInterval = 0;
+	std::uint32_t mFill = 0;
+	std::uint64_t mCount = 0;
+
+	std::size_t
+	readBytes(std::byte* dest, std::size_t size) override;
+
+	void
+	readFrame(std::byte* dest, std::size_t size);
+
+	void
+	readHeader();
+
+public:
+	struct Exception : Stream::Input::Exception
+	{ using Stream::Input::Exception::Exception; };
+
+	/**
+	 * @brief	Default largest interval accepted
+	 */
+	static constexpr std::uint32_t MaxInterval = 16*1024*1024;
+
+	/**
+	 * @param	md Digest of the signatures, nullptr for EdDSA keys
+	 * @param	maxInterval Largest interval accepted, an interval is buffered before its checkpoint is verified.
+	 * 			Streams with a larger one fail with std::errc::bad_message.
+	 */
+	CheckpointInput(EVP_MD const* md, Key const& verifyKey, std::uint32_t maxInterval = MaxInterval);
+
+	CheckpointInput(CheckpointInput&& other) noexcept;
+
+	friend void
+	swap(CheckpointInput& a, CheckpointInput& b) noexcept;
+
+	CheckpointInput&
+	operator=(CheckpointInput&& other) noexcept;
+
+	/**
+	 * @return	Number of checkpoints verified so far
+	 */
+	[[nodiscard]] std::uint64_t
+	getCheckpointCount() const noexcept;
+};//class Security::CheckpointInput
+
+/**
+ * @brief	Stream::Output signed checkpoint writer
+ * @details	Data is written as it comes, a checkpoint is inserted once interval bytes have been written since the last
+ * 			one or, on a write, once period has elapsed since the last one. Call checkpoint to sign the data written
+ * 			so far at any time, e.g. from a timer while the stream is idle, then flush.
+ * @see		Checkpoint for the stream format
+ * @class	CheckpointOutput Checkpoint.hpp "Security/Checkpoint.hpp"
+ */
+class CheckpointOutput : public Stream::TransformOutput {
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	std::optional<Signer> mSigner;
+	std::chrono::steady_clock::duration mPeriod{};
+	std::chrono::steady_clock::time_point mLast;
+	std::uint32_t mInterval = 0;
+	std::uint32_t mFill = 0;
+	std::uint64_t mCount = 0;
+	bool mHeaderWritten = false;
+
+	std::size_t
+	writeBytes(std::byte const* src, std::size_t size) override;
+
+	void
+	writeHeader();
+
+public:
+	struct Exception : Stream::Output::Exception
+	{ using Stream::Output::Exception::Exception; };
+
+	/**
+	 * @param	md Digest of the signatures, nullptr for EdDSA keys
+	 * @param	interval Maximum number of bytes between two checkpoints
+	 * @param	period Maximum time between two checkpoints while data is written, zero to disable
+	 */
+	CheckpointOutput(EVP_MD const* md, Key const& signKey, std::uint32_t interval = 1024*1024,
+			std::chrono::milliseconds period = std::chrono::milliseconds::zero());
+
+	CheckpointOutput(CheckpointOutput&& other) noexcept;
+
+	friend void
+	swap(CheckpointOutput& a, CheckpointOutput& b) noexcept;
+
+	CheckpointOutput&
+	operator=(CheckpointOutput&& other) noexcept;
+
+	~CheckpointOutput();
+
+	/**
+	 * @brief	Sign the data written since the last checkpoint, nothing is written if there is none
+	 */
+	void
+	checkpoint();
+
+	/**
+	 * @return	Number of checkpoints written so far
+	 */
+	[[nodiscard]] std::uint64_t
+	getCheckpointCount() const noexcept;
+};//class Security::CheckpointOutput
+
+/**
+ * @brief	Stream::Input / Stream::Output signed checkpoint verifier and writer
+ * @details	Authenticates unbounded streams with bounded latency instead of a single signature at the end.
+ * 			Stream format:
+ * 			- Header: 4 bytes big-endian interval N.
+ * 			- Frames: 1 byte type, 4 bytes big-endian payload size and the payload. A data frame (type 0) holds 1 to N
+ * 			  bytes, at most N bytes of data frames are between two checkpoints. A checkpoint frame (type 1) holds the
+ * 			  signature of the chain value c(k).
+ * 			The chain starts with c(0) = H("Security::Checkpoint" || header), c(k) = H(c(k-1) || data since checkpoint
+ * 			k-1), H is md or SHA-512 if md is nullptr. Every checkpoint covers all the data before it, a stream cut
+ * 			exactly after a checkpoint looks complete.
+ * @class	Checkpoint Checkpoint.hpp "Security/Checkpoint.hpp"
+ */
+class Checkpoint : public CheckpointInput, public CheckpointOutput {
+	friend class CheckpointInput;
+	friend class CheckpointOutput;
+
+	static EVP_MD const*
+	ChainDigest(EVP_MD const* md) noexcept;
+
+	/**
+	 * @param	error Set to the OpenSSL error of the failure, the caller throws the exception of its own stream
+	 */
+	[[nodiscard]] static bool
+	Start(EVP_MD_CTX* ctx, std::byte const* header, unsigned long& error);
+
+	/**
+	 * @param	size Set to the size of chain
+	 * @param	error Set to the OpenSSL error of the failure, the caller throws the exception of its own stream
+	 */
+	[[nodiscard]] static bool
+	Next(EVP_MD_CTX* ctx, std::byte* chain, std::size_t& size, unsigned long& error);
+
+public:
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::Checkpoint::Exception
+
+	Checkpoint(EVP_MD const* md, Key const& key, std::uint32_t interval = 1024*1024,
+			std::chrono::milliseconds period = std::chrono::milliseconds::zero());
+
+	Checkpoint(EVP_MD const* mdIn, Key const& verifyKey, EVP_MD const* mdOut, Key const& signKey,
+			std::uint32_t interval = 1024*1024, std::chrono::milliseconds period = std::chrono::milliseconds::zero());
+};//class Security::Checkpoint
+
+void
+swap(Checkpoint& a, Checkpoint& b) noexcept;
+
+std::error_code
+make_error_code(Checkpoint::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::Checkpoint::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_CHECKPOINT_HPP
@@ -0,0 +1,151 @@
+#ifndef SECURITY_CHUNKDIGEST_HPP
+#define SECURITY_CHUNKDIGEST_HPP
+
+#include "Key.hpp"
+#include <Stream/Transparent.hpp>
+#include <functional>
+#include <span>
+
+namespace Security {
+
+/**
+ * @brief	Content defined chunking with a digest per chunk
+ * @details	Chunk boundaries are found with the FastCDC Gear rolling hash using normalized chunking: no boundary in the
+ * 			first averageSize / 4 bytes of a chunk, a stricter mask before averageSize and a looser one after it, and a
+ * 			forced boundary at averageSize * 8 bytes. averageSize is rounded to a power of two. Boundaries only depend
+ * 			on the content, so identical data produces identical chunks wherever it is in the stream.
+ * 			Every chunk is reported with callback(offset, size, digest) as soon as its boundary is found.
+ * @class	ContentChunker ChunkDigest.hpp "Security/ChunkDigest.hpp"
+ */
+class ContentChunker {
+public:
+	using Callback = std::function<void(std::uint64_t, std::size_t, std::span<std::byte const>)>;
+
+private:
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	Callback mCallback;
+	std::size_t mMinSize = 0;
+	std::size_t mAverageSize = 0;
+	std::size_t mMaxSize = 0;
+	std::uint64_t mMaskS = 0;
+	std::uint64_t mMaskL = 0;
+	std::uint64_t mHash = 0;
+	std::uint64_t mOffset = 0;
+	std::size_t mSize = 0;
+
+	bool
+	cut(unsigned long& error);
+
+public:
+	ContentChunker() noexcept = default;
+
+	ContentChunker(EVP_MD const* md, Callback callback, std::size_t averageSize);
+
+	/**
+	 * @param	error Set to the OpenSSL error of the failure, the caller throws the exception of its own stream
+	 * @return	Whether the data was processed
+	 */
+	[[nodiscard]] bool
+	update(void const* data, std::size_t size, unsigned long& error);
+
+	/**
+	 * @brief	Report the pending bytes as the last chunk
+	 */
+	[[nodiscard]] bool
+	finalize(unsigned long& error);
+};//class Security::ContentChunker
+
+/**
+ * @brief	Stream::Input chunk %Digest observer
+ * @class	ChunkDigestInput ChunkDigest.hpp "Security/ChunkDigest.hpp"
+ */
+class ChunkDigestInput : public Stream::TransparentInput {
+	ContentChunker mChunker;
+
+	std::size_t
+	readBytes(std::byte* dest, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Input::Exception
+	{ using Stream::Input::Exception::Exception; };
+
+	ChunkDigestInput(EVP_MD const* md, ContentChunker::Callback callback, std::size_t averageSize = 8*1024);
+
+	ChunkDigestInput(ChunkDigestInput&& other) noexcept;
+
+	friend void
+	swap(ChunkDigestInput& a, ChunkDigestInput& b) noexcept;
+
+	ChunkDigestInput&
+	operator=(ChunkDigestInput&& other) noexcept;
+
+	/**
+	 * @brief	Report the pending bytes as the last chunk, to be called at the end of the data
+	 */
+	void
+	finalizeInputChunk();
+};//class Security::ChunkDigestInput
+
+/**
+ * @brief	Stream::Output chunk %Digest observer
+ * @class	ChunkDigestOutput ChunkDigest.hpp "Security/ChunkDigest.hpp"
+ */
+class ChunkDigestOutput : public Stream::TransparentOutput {
+	ContentChunker mChunker;
+
+	std::size_t
+	writeBytes(std::byte const* src, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Output::Exception
+	{ using Stream::Output::Exception::Exception; };
+
+	ChunkDigestOutput(EVP_MD const* md, ContentChunker::Callback callback, std::size_t averageSize = 8*1024);
+
+	ChunkDigestOutput(ChunkDigestOutput&& other) noexcept;
+
+	friend void
+	swap(ChunkDigestOutput& a, ChunkDigestOutput& b) noexcept;
+
+	ChunkDigestOutput&
+	operator=(ChunkDigestOutput&& other) noexcept;
+
+	/**
+	 * @brief	Report the pending bytes as the last chunk, to be called at the end of the data
+	 */
+	void
+	finalizeOutputChunk();
+};//class Security::ChunkDigestOutput
+
+/**
+ * @brief	Stream::Input / Stream::Output chunk %Digest observer
+ * @details	See ContentChunker.
+ * @class	ChunkDigest ChunkDigest.hpp "Security/ChunkDigest.hpp"
+ */
+class ChunkDigest : public ChunkDigestInput, public ChunkDigestOutput {
+public:
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::ChunkDigest::Exception
+
+	ChunkDigest(EVP_MD const* md, ContentChunker::Callback inCallback, ContentChunker::Callback outCallback,
+			std::size_t averageSize = 8*1024);
+};//class Security::ChunkDigest
+
+void
+swap(ChunkDigest& a, ChunkDigest& b) noexcept;
+
+std::error_code
+make_error_code(ChunkDigest::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::ChunkDigest::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_CHUNKDIGEST_HPP
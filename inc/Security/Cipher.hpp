@@ -3,18 +3,35 @@
 
 #include "Key.hpp"
 #include <Stream/Transform.hpp>
+#include <cstdlib>
+#include <limits>
+#include <span>
+#include <string>
 
 namespace Security {
 
 /**
  * @brief	Stream::Input %Cipher decryptor
+ * @details	For AEAD ciphers (GCM, ChaCha20-Poly1305) the last 16 bytes of the source are the tag,
+ * 			they are held back and never decrypted.
  * @class	CipherDecrypt Cipher.hpp "Security/Cipher.hpp"
  */
 class CipherDecrypt : public Stream::TransformInput {
 	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> mCtx{nullptr, EVP_CIPHER_CTX_free};
-	std::unique_ptr<unsigned char> mTempBeg;
+	std::unique_ptr<unsigned char, decltype(&std::free)> mTempBeg{nullptr, std::free};
 	unsigned char* mTempCurr = nullptr;
 	unsigned char const* mTempEnd = nullptr;
+	std::size_t mTempSize = 0;
+	std::unique_ptr<unsigned char, decltype(&std::free)> mHeldBeg{nullptr, std::free};
+	std::size_t mHeldSize = 0;
+	std::size_t mHeldFill = 0;
+	std::size_t mReadAheadSize = 0;
+	unsigned char mTag[EVP_GCM_TLS_TAG_LEN];
+	unsigned char mIv[EVP_MAX_IV_LENGTH];
+	int mTagSize = 0;
+	int mTagFill = 0;
+	std::uint64_t mInputSize = std::numeric_limits<std::uint64_t>::max();
+	bool mFinalized = false;
 	bool mFinalizeWhenNoData = true;
 
 	std::size_t
@@ -23,6 +40,12 @@ class CipherDecrypt : public Stream::TransformInput {
 	void
 	init(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv);
 
+	void
+	reserveTemp(std::size_t size);
+
+	void
+	rearm(unsigned char const* key, std::byte const* iv);
+
 public:
 	struct Exception : Stream::Input::Exception
 	{ using Stream::Input::Exception::Exception; };
@@ -37,20 +60,82 @@ public:
 	CipherDecrypt&
 	operator=(CipherDecrypt&& other) noexcept;
 
+	/**
+	 * @brief	Feed additional authenticated data of an AEAD cipher
+	 * @details	Must be called before any data is read, not supported by non AEAD ciphers.
+	 */
+	void
+	updateAAD(void const* aad, std::size_t size);
+
+	/**
+	 * @brief	Finalize decryption
+	 * @details	For AEAD ciphers the trailing tag is read from the source if it has not been read yet and verified,
+	 * 			Exception with std::errc::bad_message is thrown when it does not match. The plaintext of the last
+	 * 			ciphertext read is held back until then, so the end of a forged message is never released.
+	 */
 	void
 	finalizeDecryption();
 
 	void
 	finalizeDecryptionWhenNoData(bool on = true);
+
+	/**
+	 * @brief	Start decrypting a new message with the same key
+	 * @details	The context, its key schedule and the buffers are reused. Decryption of the current message does not
+	 * 			have to be finalized, its pending plaintext and input size are discarded. Not supported by ciphers
+	 * 			without an iv.
+	 */
+	void
+	reset(std::byte const* iv);
+
+	/**
+	 * @brief	Start decrypting a new message with a new key of the same cipher
+	 */
+	void
+	reset(Secret<> const& key, std::byte const* iv);
+
+	/**
+	 * @brief	Decrypt reads smaller than size bytes in batches of size bytes
+	 * @details	Batches are decrypted into a reusable cache line aligned buffer and small reads are served from it,
+	 * 			0 turns read-ahead off. Reads smaller than two blocks of a block cipher are always buffered.
+	 */
+	void
+	setReadAheadSize(std::size_t size);
+
+	/**
+	 * @brief	Finalize decryption as soon as size more bytes of ciphertext have been read from the source
+	 * @details	size includes the tag of AEAD ciphers. The source is not read past the ciphertext and its end is
+	 * 			never hit, so no exception is thrown and caught per decrypted object. Use atEnd() to stop reading.
+	 */
+	void
+	setInputSize(std::uint64_t size) noexcept;
+
+	/**
+	 * @return	Whether decryption has been finalized and all of the plaintext has been read
+	 * @details	Reading past this point throws Exception with std::errc::no_message_available.
+	 */
+	[[nodiscard]] bool
+	atEnd() const noexcept;
+
+	/**
+	 * @brief	Continue decrypting a counter mode stream from a plaintext offset
+	 * @details	The counter block for offset is computed from the iv, no data is decrypted to get there.
+	 * 			The source must be positioned at the same offset of the ciphertext before the next read.
+	 */
+	void
+	seek(std::uint64_t offset);
 };//class Security::CipherDecrypt
 
 /**
  * @brief	Stream::Output %Cipher encryptor
+ * @details	For AEAD ciphers (GCM, ChaCha20-Poly1305) a 16 bytes tag is appended on finalization.
  * @class	CipherEncrypt Cipher.hpp "Security/Cipher.hpp"
  */
 class CipherEncrypt : public Stream::TransformOutput {
 	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> mCtx{nullptr, EVP_CIPHER_CTX_free};
 	int mExtSize = 0;
+	int mTagSize = 0;
+	bool mFinalized = false;
 
 	std::size_t
 	writeBytes(std::byte const* src, std::size_t size) override;
@@ -58,6 +143,9 @@ class CipherEncrypt : public Stream::TransformOutput {
 	void
 	init(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv);
 
+	void
+	rearm(unsigned char const* key, std::byte const* iv);
+
 public:
 	struct Exception : Stream::Output::Exception
 	{ using Stream::Output::Exception::Exception; };
@@ -74,8 +162,34 @@ public:
 
 	~CipherEncrypt();
 
+	/**
+	 * @brief	Feed additional authenticated data of an AEAD cipher
+	 * @details	Must be called before any data is written, not supported by non AEAD ciphers.
+	 */
+	void
+	updateAAD(void const* aad, std::size_t size);
+
+	/**
+	 * @brief	Finalize encryption
+	 * @details	For AEAD ciphers the tag is appended to the output.
+	 */
 	void
 	finalizeEncryption();
+
+	/**
+	 * @brief	Start encrypting a new message with the same key
+	 * @details	The context and its key schedule are reused. Ciphertext already written stays buffered and is flushed
+	 * 			to the sink, a message that has not been finalized is left without its final block and tag.
+	 * 			Not supported by ciphers without an iv.
+	 */
+	void
+	reset(std::byte const* iv);
+
+	/**
+	 * @brief	Start encrypting a new message with a new key of the same cipher
+	 */
+	void
+	reset(Secret<> const& key, std::byte const* iv);
 };//class Security::CipherEncrypt
 
 /**
@@ -83,11 +197,86 @@ public:
  * @class Cipher Cipher.hpp "Security/Cipher.hpp"
  */
 class Cipher : public CipherDecrypt, public CipherEncrypt {
+	friend class CipherDecrypt;
+	friend class CipherEncrypt;
+	friend class ParallelCipher;
+	friend class AsyncCipherEncrypt;
+
+	static int
+	TagSize(EVP_CIPHER const* cipher) noexcept;
+
+	/**
+	 * @brief	Position a counter mode ctx at offset bytes from iv
+	 */
+	static bool
+	Seek(EVP_CIPHER_CTX* ctx, unsigned char const* iv, std::uint64_t offset) noexcept;
+
+	static std::uint64_t
+	CryptFile(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+			std::string const& src, std::string const& dest, bool encrypt);
+
 public:
-	struct Exception {
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
 		enum class Code : int {};
 	};//struct Security::Cipher::Exception
 
+	/**
+	 * @brief	A message of a batch
+	 */
+	struct Job {
+		Secret<> const* key = nullptr;
+		std::byte const* iv = nullptr;
+		std::byte const* aad = nullptr;
+		std::size_t aadSize = 0;
+		std::byte const* src = nullptr;
+		std::size_t srcSize = 0;
+		/// Room for srcSize bytes, a block more for block ciphers and the tag of AEAD ciphers when encrypting
+		std::byte* dest = nullptr;
+		/// Size of the output
+		std::size_t destSize = 0;
+		/// Whether the padding or the tag of the message has not been verified
+		bool failed = false;
+	};//struct Security::Cipher::Job
+
+	/**
+	 * @brief	Encrypt independent messages in one call
+	 * @details	A single context is set up for the batch, consecutive jobs with the same key reuse its key schedule.
+	 * 			Output of a job is identical to CipherEncrypt with the same cipher, key and iv.
+	 */
+	static void
+	Encrypt(EVP_CIPHER const* cipher, std::span<Job> jobs);
+
+	/**
+	 * @brief	Decrypt independent messages in one call
+	 * @details	The last 16 bytes of a message of an AEAD cipher are its tag. The output of a job that failed
+	 * 			verification is wiped.
+	 * @return	Number of jobs that failed verification
+	 */
+	static std::size_t
+	Decrypt(EVP_CIPHER const* cipher, std::span<Job> jobs);
+
+	/**
+	 * @brief	Encrypt a file into another one through memory mappings
+	 * @details	Output is identical to CipherEncrypt with the same cipher, key and iv. src and dest must be different
+	 * 			files, Exception with std::errc::invalid_argument is thrown otherwise. dest is removed on failure.
+	 * @return	Size of the encrypted file
+	 */
+	static std::uint64_t
+	EncryptFile(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+			std::string const& src, std::string const& dest);
+
+	/**
+	 * @brief	Decrypt a file into another one through memory mappings
+	 * @details	When the padding or the tag does not verify, dest is removed and
+	 * 			Exception with std::errc::bad_message is thrown. src and dest must be different files, dest is removed
+	 * 			on any failure.
+	 * @return	Size of the decrypted file
+	 */
+	static std::uint64_t
+	DecryptFile(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+			std::string const& src, std::string const& dest);
+
 	Cipher(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv);
 
 	Cipher(EVP_CIPHER const* decCipher, Secret<> const& decKey, std::byte const* decIv,
@@ -0,0 +1,70 @@
+#ifndef SECURITY_CIPHERPOOL_HPP
+#define SECURITY_CIPHERPOOL_HPP
+
+#include "Cipher.hpp"
+#include <vector>
+
+namespace Security {
+
+/**
+ * @brief	Thread local pools of ready CipherDecrypt and CipherEncrypt streams
+ * @details	A stream released by a thread is reset and handed out again to the same thread, its context and buffers
+ * 			are not reallocated and its key schedule is kept when it is requested with the same cipher and key,
+ * 			except for ciphers without an iv whose key stream can only be restarted with the key.
+ * 			A stream taken from the pool has to be chained to its source or sink again.
+ * @class	CipherPool CipherPool.hpp "Security/CipherPool.hpp"
+ */
+class CipherPool {
+public:
+	/**
+	 * @brief	Maximum number of released streams kept per thread and stream type
+	 */
+	static constexpr std::size_t Capacity = 16;
+
+	/**
+	 * @brief	A stream taken from the pool, returned to the pool of the thread on destruction
+	 * @details	Like destroying it, releasing an encryptor finalizes it and flushes it to its sink.
+	 */
+	template <typename T>
+	class Lease {
+		friend class CipherPool;
+		struct Entry;
+		std::unique_ptr<Entry> mEntry;
+
+		explicit Lease(std::unique_ptr<Entry> entry) noexcept;
+
+	public:
+		Lease(Lease&& other) noexcept;
+
+		Lease&
+		operator=(Lease&& other) noexcept;
+
+		~Lease();
+
+		T&
+		operator*() const noexcept;
+
+		T*
+		operator->() const noexcept;
+	};//class Security::CipherPool::Lease<T>
+
+private:
+	template <typename T>
+	static std::vector<std::unique_ptr<typename Lease<T>::Entry>>&
+	Released();
+
+	template <typename T>
+	static Lease<T>
+	Acquire(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv);
+
+public:
+	static Lease<CipherDecrypt>
+	Decrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv);
+
+	static Lease<CipherEncrypt>
+	Encrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv);
+};//class Security::CipherPool
+
+}//namespace Security
+
+#endif //SECURITY_CIPHERPOOL_HPP
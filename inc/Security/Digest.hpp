@@ -3,20 +3,43 @@
 
 #include "Key.hpp"
 #include <Stream/Transparent.hpp>
+#include <array>
+#include <functional>
+#include <span>
 #include <vector>
 
 namespace Security {
 
+/**
+ * @brief	%Digest algorithms whose digest size is known at compile time, see Digest::Compute<A>
+ */
+struct MD5 { static constexpr std::size_t Size = 16; static constexpr char const* Name = "MD5"; };
+struct SHA1 { static constexpr std::size_t Size = 20; static constexpr char const* Name = "SHA1"; };
+struct SHA224 { static constexpr std::size_t Size = 28; static constexpr char const* Name = "SHA2-224"; };
+struct SHA256 { static constexpr std::size_t Size = 32; static constexpr char const* Name = "SHA2-256"; };
+struct SHA384 { static constexpr std::size_t Size = 48; static constexpr char const* Name = "SHA2-384"; };
+struct SHA512 { static constexpr std::size_t Size = 64; static constexpr char const* Name = "SHA2-512"; };
+struct SHA3_256 { static constexpr std::size_t Size = 32; static constexpr char const* Name = "SHA3-256"; };
+struct SHA3_512 { static constexpr std::size_t Size = 64; static constexpr char const* Name = "SHA3-512"; };
+
 /**
  * @brief	Stream::Input %Digest observer
  * @class	DigestInput Digest.hpp "Security/Digest.hpp"
  */
 class DigestInput : public Stream::TransparentInput {
 	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mScratch{nullptr, EVP_MD_CTX_free};
+	std::uint64_t mProcessed = 0;
+	std::uint64_t mCheckpointInterval = 0;
+	std::function<void(std::uint64_t, std::span<std::byte const>)> mCheckpoint;
+	std::vector<std::byte> mCheckpointDigest;
 
 	std::size_t
 	readBytes(std::byte* dest, std::size_t size) override;
 
+	void
+	update(std::byte const* data, std::size_t size);
+
 protected:
 	DigestInput(EVP_MD const* md, EVP_PKEY* key);
 
@@ -41,6 +64,25 @@ public:
 
 	[[nodiscard]] std::vector<std::byte>
 	getInputDigest() const;
+
+	/**
+	 * @brief	Write the digest of the data so far to dest without allocating a result
+	 * @details	The running state is copied to a scratch context of the calling thread to be finalized, the provider
+	 * 			allocates the copy. Concurrent calls are safe as long as no data is passed through the stream.
+	 * @return	Size of the digest
+	 * @throws	Digest::Exception std::errc::invalid_argument if dest is smaller than getInputDigestSize()
+	 */
+	std::size_t
+	getInputDigest(std::span<std::byte> dest) const;
+
+	/**
+	 * @brief	Report the digest of the data so far every interval bytes
+	 * @details	callback(offset, digest) is called each time offset, a multiple of interval, bytes have been
+	 * 			processed. The digest is finalized on a scratch context of the stream, the running digest is not
+	 * 			affected. An interval of 0 disables checkpoints.
+	 */
+	void
+	setCheckpoint(std::uint64_t interval, std::function<void(std::uint64_t, std::span<std::byte const>)> callback);
 };//class Security::DigestInput
 
 /**
@@ -49,10 +91,18 @@ public:
  */
 class DigestOutput : public Stream::TransparentOutput {
 	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mScratch{nullptr, EVP_MD_CTX_free};
+	std::uint64_t mProcessed = 0;
+	std::uint64_t mCheckpointInterval = 0;
+	std::function<void(std::uint64_t, std::span<std::byte const>)> mCheckpoint;
+	std::vector<std::byte> mCheckpointDigest;
 
 	std::size_t
 	writeBytes(std::byte const* src, std::size_t size) override;
 
+	void
+	update(std::byte const* data, std::size_t size);
+
 protected:
 	DigestOutput(EVP_MD const* md, EVP_PKEY* key);
 
@@ -77,6 +127,25 @@ public:
 
 	[[nodiscard]] std::vector<std::byte>
 	getOutputDigest() const;
+
+	/**
+	 * @brief	Write the digest of the data so far to dest without allocating a result
+	 * @details	The running state is copied to a scratch context of the calling thread to be finalized, the provider
+	 * 			allocates the copy. Concurrent calls are safe as long as no data is passed through the stream.
+	 * @return	Size of the digest
+	 * @throws	Digest::Exception std::errc::invalid_argument if dest is smaller than getOutputDigestSize()
+	 */
+	std::size_t
+	getOutputDigest(std::span<std::byte> dest) const;
+
+	/**
+	 * @brief	Report the digest of the data so far every interval bytes
+	 * @details	callback(offset, digest) is called each time offset, a multiple of interval, bytes have been
+	 * 			processed. The digest is finalized on a scratch context of the stream, the running digest is not
+	 * 			affected. An interval of 0 disables checkpoints.
+	 */
+	void
+	setCheckpoint(std::uint64_t interval, std::function<void(std::uint64_t, std::span<std::byte const>)> callback);
 };//class Security::DigestOutput
 
 /**
@@ -90,19 +159,76 @@ class Digest : public DigestInput, public DigestOutput {
 	static std::size_t
 	Size(EVP_MD_CTX* ctx);
 
-	static std::vector<std::byte>
-	Value(EVP_MD_CTX* ctx);
+	static std::size_t
+	Value(EVP_MD_CTX* ctx, EVP_MD_CTX* scratch, std::span<std::byte> dest);
+
+	/**
+	 * @brief	Value on a scratch context of the calling thread
+	 */
+	static std::size_t
+	Value(EVP_MD_CTX* ctx, std::span<std::byte> dest);
+
+	static EVP_MD*
+	Fetch(char const* name);
 
 public:
+	/**
+	 * @return	Implementation of the algorithm A, fetched once per process
+	 */
+	template <typename A>
+	static EVP_MD const*
+	Get()
+	{
+		static std::unique_ptr<EVP_MD, decltype(&EVP_MD_free)> const md{Fetch(A::Name), EVP_MD_free};
+		return md.get();
+	}
+
+	/**
+	 * @brief	Compute the digest of data with the algorithm A
+	 * @details	A context of the calling thread is reused and initialized with an implementation fetched once, no
+	 * 			memory is allocated. Only this form is allocation-free, copying a running digest allocates.
+	 */
+	template <typename A>
+	static std::array<std::byte, A::Size>
+	Compute(void const* data, std::size_t count)
+	{
+		std::array<std::byte, A::Size> val;
+		Compute(data, count, Get<A>(), val.data());
+		return val;
+	}
+
+	template <typename A>
+	static void
+	Compute(void const* data, std::size_t count, std::span<std::byte, A::Size> dest)
+	{ Compute(data, count, Get<A>(), dest.data()); }
+
+	/**
+	 * @brief	Write the digest of data to dest, EVP_MD_size(md) bytes
+	 * @details	A context of the calling thread is reused.
+	 */
+	static void
+	Compute(void const* data, std::size_t count, EVP_MD const* md, std::byte* dest);
+
 	static std::vector<std::byte>
 	Compute(void const* data, std::size_t count, EVP_MD const* md);
 
 	static std::vector<std::byte>
 	Compute(void const* data, std::size_t count, EVP_MD const* md, Key const& key);
 
+	/**
+	 * @brief	Compute digests of independent messages in one call
+	 * @details	The digest of messages[i] is written to dest + i * EVP_MD_size(md). The implementation of md is fetched
+	 * 			once and a single context is reinitialized for each message.
+	 */
+	static void
+	Compute(std::span<std::span<std::byte const> const> messages, EVP_MD const* md, std::byte* dest);
+
 	static bool
 	Matches(std::vector<std::byte> const& digest1, std::vector<std::byte> const& digest2) noexcept;
 
+	static bool
+	Matches(std::span<std::byte const> digest1, std::span<std::byte const> digest2) noexcept;
+
 	struct Exception : std::system_error {
 		using std::system_error::system_error;
 		enum class Code : int {};
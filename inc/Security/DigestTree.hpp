@@ -0,0 +1,165 @@
+#ifndef SECURITY_DIGESTTREE_HPP
+#define SECURITY_DIGESTTREE_HPP
+
+#include "Key.hpp"
+#include "WorkerPool.hpp"
+#include <Stream/Transparent.hpp>
+#include <vector>
+
+namespace Security {
+
+/**
+ * @brief	Incremental Merkle tree hash of a byte sequence split into fixed size leaves
+ * @details	The tree is the RFC 6962 Merkle Tree Hash over the leaves: a leaf is hashed as H(0x00 || leaf), a node as
+ * 			H(0x01 || left || right) and the left subtree of n leaves holds the largest power of two less than n leaves.
+ * 			Every leaf is leafSize bytes except the last one, the digest of empty data is H(). The digest is not the
+ * 			plain digest of the data, it depends on md and leafSize. Full leaves are hashed on a WorkerPool.
+ * @class	TreeHash DigestTree.hpp "Security/DigestTree.hpp"
+ */
+class TreeHash {
+	EVP_MD const* mMd = nullptr;
+	WorkerPool* mPool = nullptr;
+	std::size_t mLeafSize = 0;
+	std::size_t mBufferSize = 0;
+	std::unique_ptr<std::byte[]> mBuffer;
+	std::size_t mFill = 0;
+	std::vector<std::pair<std::uint64_t, std::vector<std::byte>>> mSubtrees;
+
+	[[nodiscard]] bool
+	hashLeaves(std::byte const* data, std::size_t count, decltype(mSubtrees)& subtrees, unsigned long& error) const;
+
+public:
+	TreeHash() noexcept = default;
+
+	TreeHash(EVP_MD const* md, std::size_t leafSize, WorkerPool& pool);
+
+	/**
+	 * @param	error Set to the OpenSSL error of the failure, the caller throws the exception of its own stream
+	 * @return	Whether the data was hashed
+	 */
+	[[nodiscard]] bool
+	update(void const* data, std::size_t size, unsigned long& error);
+
+	[[nodiscard]] std::size_t
+	getDigestSize() const noexcept;
+
+	/**
+	 * @return	Digest of the data so far
+	 */
+	[[nodiscard]] std::vector<std::byte>
+	getDigest() const;
+};//class Security::TreeHash
+
+/**
+ * @brief	Stream::Input tree %Digest observer
+ * @class	DigestTreeInput DigestTree.hpp "Security/DigestTree.hpp"
+ */
+class DigestTreeInput : public Stream::TransparentInput {
+	TreeHash mHash;
+
+	std::size_t
+	readBytes(std::byte* dest, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Input::Exception
+	{ using Stream::Input::Exception::Exception; };
+
+	explicit DigestTreeInput(EVP_MD const* md, std::size_t leafSize = 1024*1024, WorkerPool& pool = WorkerPool::Default());
+
+	DigestTreeInput(DigestTreeInput&& other) noexcept;
+
+	friend void
+	swap(DigestTreeInput& a, DigestTreeInput& b) noexcept;
+
+	DigestTreeInput&
+	operator=(DigestTreeInput&& other) noexcept;
+
+	[[nodiscard]] std::size_t
+	getInputDigestSize() const noexcept;
+
+	[[nodiscard]] std::vector<std::byte>
+	getInputDigest() const;
+};//class Security::DigestTreeInput
+
+/**
+ * @brief	Stream::Output tree %Digest observer
+ * @class	DigestTreeOutput DigestTree.hpp "Security/DigestTree.hpp"
+ */
+class DigestTreeOutput : public Stream::TransparentOutput {
+	TreeHash mHash;
+
+	std::size_t
+	writeBytes(std::byte const* src, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Output::Exception
+	{ using Stream::Output::Exception::Exception; };
+
+	explicit DigestTreeOutput(EVP_MD const* md, std::size_t leafSize = 1024*1024, WorkerPool& pool = WorkerPool::Default());
+
+	DigestTreeOutput(DigestTreeOutput&& other) noexcept;
+
+	friend void
+	swap(DigestTreeOutput& a, DigestTreeOutput& b) noexcept;
+
+	DigestTreeOutput&
+	operator=(DigestTreeOutput&& other) noexcept;
+
+	[[nodiscard]] std::size_t
+	getOutputDigestSize() const noexcept;
+
+	[[nodiscard]] std::vector<std::byte>
+	getOutputDigest() const;
+};//class Security::DigestTreeOutput
+
+/**
+ * @brief	Stream::Input / Stream::Output tree %Digest observer
+ * @details	See TreeHash for the construction.
+ * @class	DigestTree DigestTree.hpp "Security/DigestTree.hpp"
+ */
+class DigestTree : public DigestTreeInput, public DigestTreeOutput {
+public:
+	/**
+	 * @brief	dest = H(0x00 || data)
+	 * @param	error Set to the OpenSSL error of the failure
+	 * @return	Whether dest was computed
+	 */
+	[[nodiscard]] static bool
+	Leaf(EVP_MD const* md, void const* data, std::size_t size, std::byte* dest, unsigned long& error);
+
+	/**
+	 * @brief	dest = H(0x01 || left || right)
+	 * @param	error Set to the OpenSSL error of the failure
+	 * @return	Whether dest was computed
+	 */
+	[[nodiscard]] static bool
+	Node(EVP_MD const* md, std::byte const* left, std::byte const* right, std::byte* dest, unsigned long& error);
+
+	static std::vector<std::byte>
+	Compute(void const* data, std::size_t count, EVP_MD const* md, std::size_t leafSize = 1024*1024,
+			WorkerPool& pool = WorkerPool::Default());
+
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::DigestTree::Exception
+
+	explicit DigestTree(EVP_MD const* md, std::size_t leafSize = 1024*1024, WorkerPool& pool = WorkerPool::Default());
+};//class Security::DigestTree
+
+void
+swap(DigestTree& a, DigestTree& b) noexcept;
+
+std::error_code
+make_error_code(DigestTree::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::DigestTree::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_DIGESTTREE_HPP
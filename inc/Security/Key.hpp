@@ -109,6 +109,14 @@ public:
 		sect571r1 	= NID_sect571r1
 	};//enum class Security::Key::EC
 
+	/**
+	 * @brief	Edwards curve signature keys
+	 */
+	enum class ED : int {
+		ED25519 	= EVP_PKEY_ED25519,
+		ED448 		= EVP_PKEY_ED448
+	};//enum class Security::Key::ED
+
 	/**
 	 * @brief	RSA key sizes
 	 */
@@ -135,6 +143,8 @@ public:
 
 	Key(EC ec);
 
+	Key(ED ed);
+
 	Key(RSA rsa);
 
 	Key(Secret<> const& hmacKey);
@@ -0,0 +1,97 @@
+#ifndef SECURITY_MAC_HPP
+#define SECURITY_MAC_HPP
+
+#include "Key.hpp"
+#include <vector>
+
+namespace Security {
+
+/**
+ * @brief	HMAC / CMAC bound to a key
+ * @details	The key is set once, the key state derived from it (the HMAC inner and outer padded key hashes, the CMAC
+ * 			subkeys) is kept and restored for every message instead of being derived again.
+ * @class	Mac Mac.hpp "Security/Mac.hpp"
+ */
+class Mac {
+	std::unique_ptr<EVP_MAC_CTX, decltype(&EVP_MAC_CTX_free)> mCtx{nullptr, EVP_MAC_CTX_free};
+	std::size_t mSize = 0;
+
+	Mac(char const* algorithm, char const* parameter, char const* name, Secret<> const& key);
+
+public:
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::Mac::Exception
+
+	/**
+	 * @brief	HMAC with md
+	 */
+	Mac(EVP_MD const* md, Secret<> const& key);
+
+	/**
+	 * @brief	CMAC with cipher
+	 */
+	Mac(EVP_CIPHER const* cipher, Secret<> const& key);
+
+	/**
+	 * @brief	Copy the key state, e.g. to use the same key on another thread
+	 */
+	Mac(Mac const& other);
+
+	Mac(Mac&& other) noexcept;
+
+	friend void
+	swap(Mac& a, Mac& b) noexcept;
+
+	Mac&
+	operator=(Mac&& other) noexcept;
+
+	[[nodiscard]] std::size_t
+	getSize() const noexcept;
+
+	/**
+	 * @brief	Start a new message
+	 */
+	void
+	init();
+
+	void
+	update(void const* data, std::size_t size);
+
+	/**
+	 * @brief	Write the MAC of the message to dest, getSize() bytes
+	 * @return	Size of the MAC
+	 */
+	std::size_t
+	final(std::byte* dest);
+
+	/**
+	 * @brief	init(), update(data, size), final(dest)
+	 */
+	std::size_t
+	compute(void const* data, std::size_t size, std::byte* dest);
+
+	[[nodiscard]] std::vector<std::byte>
+	compute(void const* data, std::size_t size);
+
+	/**
+	 * @brief	Compare the MAC of data with mac in constant time
+	 */
+	[[nodiscard]] bool
+	verify(void const* data, std::size_t size, std::byte const* mac, std::size_t macSize);
+};//class Security::Mac
+
+std::error_code
+make_error_code(Mac::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::Mac::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_MAC_HPP
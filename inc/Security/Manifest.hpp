@@ -0,0 +1,184 @@
+#ifndef SECURITY_MANIFEST_HPP
+#define SECURITY_MANIFEST_HPP
+
+#include "Key.hpp"
+#include "WorkerPool.hpp"
+#include <Stream/Transparent.hpp>
+#include <span>
+#include <vector>
+
+namespace Security {
+
+/**
+ * @brief	Signed list of the digests of the fixed size chunks of some data
+ * @details	Only the manifest is signed. Once its signature is verified every chunk can be verified on its own, in
+ * 			any order and in parallel. Every chunk is chunkSize bytes except the last one.
+ * 			A manifest is written as the chunk size, the data size, the length and the name of the digest, the chunk
+ * 			digests, the size of the signature and the signature. Integers are big-endian, the signature covers
+ * 			everything before its size.
+ * @class	Manifest Manifest.hpp "Security/Manifest.hpp"
+ */
+class Manifest {
+	friend class ManifestInput;
+
+	std::unique_ptr<EVP_MD, decltype(&EVP_MD_free)> mMd{nullptr, EVP_MD_free};
+	std::uint32_t mChunkSize = 0;
+	std::uint64_t mDataSize = 0;
+	std::vector<std::byte> mDigests;
+	std::vector<std::byte> mSignature;
+
+	[[nodiscard]] std::vector<std::byte>
+	getBody() const;
+
+public:
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::Manifest::Exception
+
+	/**
+	 * @param	digests Digests of the chunks, one after another
+	 */
+	Manifest(EVP_MD const* md, std::uint32_t chunkSize, std::uint64_t dataSize, std::vector<std::byte> digests);
+
+	/**
+	 * @brief	Read a manifest written by operator<<
+	 * @param	maxChunkCount Largest number of chunks accepted, the digests are allocated before the signature is
+	 * 			verified
+	 * @throws	Exception std::errc::bad_message if the manifest is malformed or has more chunks
+	 */
+	explicit Manifest(Stream::Input& input, std::uint64_t maxChunkCount = 1024*1024);
+
+	/**
+	 * @brief	Manifest of data, chunks are hashed on pool
+	 */
+	static Manifest
+	Compute(void const* data, std::size_t count, EVP_MD const* md, std::uint32_t chunkSize,
+			WorkerPool& pool = WorkerPool::Default());
+
+	Manifest(Manifest&& other) noexcept;
+
+	friend void
+	swap(Manifest& a, Manifest& b) noexcept;
+
+	Manifest&
+	operator=(Manifest&& other) noexcept;
+
+	[[nodiscard]] std::uint32_t
+	getChunkSize() const noexcept;
+
+	[[nodiscard]] std::uint64_t
+	getDataSize() const noexcept;
+
+	[[nodiscard]] std::uint64_t
+	getChunkCount() const noexcept;
+
+	/**
+	 * @param	md Digest of the signature, nullptr for EdDSA keys
+	 */
+	void
+	sign(EVP_MD const* md, Key const& signKey);
+
+	[[nodiscard]] bool
+	verifySignature(EVP_MD const* md, Key const& verifyKey) const;
+
+	/**
+	 * @return	Whether data is the chunk at index, thread safe
+	 */
+	[[nodiscard]] bool
+	verifyChunk(std::uint64_t index, void const* data, std::size_t size) const;
+
+	/**
+	 * @brief	Verify chunks[i] as the chunk at first + i on pool
+	 * @return	Element i is true if chunks[i] is valid
+	 */
+	[[nodiscard]] std::vector<bool>
+	verifyChunks(std::uint64_t first, std::span<std::span<std::byte const> const> chunks,
+			WorkerPool& pool = WorkerPool::Default()) const;
+
+	friend Stream::Output&
+	operator<<(Stream::Output& output, Manifest const& manifest);
+};//class Security::Manifest
+
+/**
+ * @brief	Stream::Input verifier of every chunk against a Manifest
+ * @details	The signature of the manifest must have been verified. A chunk is read whole and released only after its
+ * 			digest matches, a chunk of the manifest is kept in memory.
+ * @class	ManifestInput Manifest.hpp "Security/Manifest.hpp"
+ */
+class ManifestInput : public Stream::TransparentInput {
+	Manifest const* mManifest = nullptr;
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	std::unique_ptr<std::byte[]> mChunk;
+	std::byte* mChunkCurr = nullptr;
+	std::byte const* mChunkEnd = nullptr;
+	std::uint64_t mIndex = 0;
+	std::uint32_t mFill = 0;
+
+	std::size_t
+	readBytes(std::byte* dest, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Input::Exception
+	{ using Stream::Input::Exception::Exception; };
+
+	explicit ManifestInput(Manifest const& manifest);
+
+	ManifestInput(ManifestInput&& other) noexcept;
+
+	friend void
+	swap(ManifestInput& a, ManifestInput& b) noexcept;
+
+	ManifestInput&
+	operator=(ManifestInput&& other) noexcept;
+};//class Security::ManifestInput
+
+/**
+ * @brief	Stream::Output observer building the Manifest of the written data
+ * @class	ManifestOutput Manifest.hpp "Security/Manifest.hpp"
+ */
+class ManifestOutput : public Stream::TransparentOutput {
+	EVP_MD const* mMd = nullptr;
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	std::uint32_t mChunkSize = 0;
+	std::uint32_t mFill = 0;
+	std::uint64_t mDataSize = 0;
+	std::vector<std::byte> mDigests;
+
+	std::size_t
+	writeBytes(std::byte const* src, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Output::Exception
+	{ using Stream::Output::Exception::Exception; };
+
+	ManifestOutput(EVP_MD const* md, std::uint32_t chunkSize = 1024*1024);
+
+	ManifestOutput(ManifestOutput&& other) noexcept;
+
+	friend void
+	swap(ManifestOutput& a, ManifestOutput& b) noexcept;
+
+	ManifestOutput&
+	operator=(ManifestOutput&& other) noexcept;
+
+	/**
+	 * @return	Unsigned manifest of the data so far
+	 */
+	[[nodiscard]] Manifest
+	getManifest() const;
+};//class Security::ManifestOutput
+
+std::error_code
+make_error_code(Manifest::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::Manifest::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_MANIFEST_HPP
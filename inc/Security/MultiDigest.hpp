@@ -0,0 +1,148 @@
+#ifndef SECURITY_MULTIDIGEST_HPP
+#define SECURITY_MULTIDIGEST_HPP
+
+#include "Key.hpp"
+#include "WorkerPool.hpp"
+#include <Stream/Transparent.hpp>
+#include <vector>
+
+namespace Security {
+
+/**
+ * @brief	Digests of the same byte sequence with several algorithms at once
+ * @details	Data is fed to the algorithms in tiles small enough to stay in L1 cache, every algorithm processes a tile
+ * 			before the next one is loaded. If a WorkerPool is given, updates of at least ParallelSize bytes are split
+ * 			across the algorithms on the pool instead.
+ * @class	DigestSet MultiDigest.hpp "Security/MultiDigest.hpp"
+ */
+class DigestSet {
+	std::vector<std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>> mCtxs;
+	WorkerPool* mPool = nullptr;
+
+public:
+	static constexpr std::size_t TileSize = 16*1024;
+	static constexpr std::size_t ParallelSize = 256*1024;
+
+	DigestSet() noexcept = default;
+
+	DigestSet(std::vector<EVP_MD const*> const& mds, WorkerPool* pool);
+
+	/**
+	 * @param	error Set to the OpenSSL error of the failure, the error queue of a worker is not the caller's one
+	 * @return	Whether every algorithm was updated
+	 */
+	[[nodiscard]] bool
+	update(void const* data, std::size_t size, unsigned long& error);
+
+	[[nodiscard]] std::size_t
+	getCount() const noexcept;
+
+	[[nodiscard]] std::size_t
+	getDigestSize(std::size_t i) const noexcept;
+
+	/**
+	 * @return	Digest of the data so far with the i th algorithm
+	 */
+	[[nodiscard]] std::vector<std::byte>
+	getDigest(std::size_t i) const;
+};//class Security::DigestSet
+
+/**
+ * @brief	Stream::Input multi algorithm %Digest observer
+ * @class	MultiDigestInput MultiDigest.hpp "Security/MultiDigest.hpp"
+ */
+class MultiDigestInput : public Stream::TransparentInput {
+	DigestSet mDigests;
+
+	std::size_t
+	readBytes(std::byte* dest, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Input::Exception
+	{ using Stream::Input::Exception::Exception; };
+
+	explicit MultiDigestInput(std::vector<EVP_MD const*> const& mds, WorkerPool* pool = nullptr);
+
+	MultiDigestInput(MultiDigestInput&& other) noexcept;
+
+	friend void
+	swap(MultiDigestInput& a, MultiDigestInput& b) noexcept;
+
+	MultiDigestInput&
+	operator=(MultiDigestInput&& other) noexcept;
+
+	[[nodiscard]] std::size_t
+	getInputDigestSize(std::size_t i) const noexcept;
+
+	/**
+	 * @return	Digest with the i th algorithm
+	 */
+	[[nodiscard]] std::vector<std::byte>
+	getInputDigest(std::size_t i) const;
+};//class Security::MultiDigestInput
+
+/**
+ * @brief	Stream::Output multi algorithm %Digest observer
+ * @class	MultiDigestOutput MultiDigest.hpp "Security/MultiDigest.hpp"
+ */
+class MultiDigestOutput : public Stream::TransparentOutput {
+	DigestSet mDigests;
+
+	std::size_t
+	writeBytes(std::byte const* src, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Output::Exception
+	{ using Stream::Output::Exception::Exception; };
+
+	explicit MultiDigestOutput(std::vector<EVP_MD const*> const& mds, WorkerPool* pool = nullptr);
+
+	MultiDigestOutput(MultiDigestOutput&& other) noexcept;
+
+	friend void
+	swap(MultiDigestOutput& a, MultiDigestOutput& b) noexcept;
+
+	MultiDigestOutput&
+	operator=(MultiDigestOutput&& other) noexcept;
+
+	[[nodiscard]] std::size_t
+	getOutputDigestSize(std::size_t i) const noexcept;
+
+	/**
+	 * @return	Digest with the i th algorithm
+	 */
+	[[nodiscard]] std::vector<std::byte>
+	getOutputDigest(std::size_t i) const;
+};//class Security::MultiDigestOutput
+
+/**
+ * @brief	Stream::Input / Stream::Output multi algorithm %Digest observer
+ * @details	See DigestSet.
+ * @class	MultiDigest MultiDigest.hpp "Security/MultiDigest.hpp"
+ */
+class MultiDigest : public MultiDigestInput, public MultiDigestOutput {
+public:
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::MultiDigest::Exception
+
+	explicit MultiDigest(std::vector<EVP_MD const*> const& mds, WorkerPool* pool = nullptr);
+};//class Security::MultiDigest
+
+void
+swap(MultiDigest& a, MultiDigest& b) noexcept;
+
+std::error_code
+make_error_code(MultiDigest::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::MultiDigest::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_MULTIDIGEST_HPP
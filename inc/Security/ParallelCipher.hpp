@@ -0,0 +1,141 @@
+#ifndef SECURITY_PARALLELCIPHER_HPP
+#define SECURITY_PARALLELCIPHER_HPP
+
+#include "Key.hpp"
+#include "WorkerPool.hpp"
+#include <Stream/Transform.hpp>
+
+namespace Security {
+
+/**
+ * @brief	Stream::Input counter mode %Cipher decryptor running on a WorkerPool
+ * @details	Output is identical to CipherDecrypt with the same cipher. Data provided by the source at once is split into
+ * 			chunks at counter offsets, so a large source buffer is needed to keep several workers busy.
+ * @class	ParallelCipherDecrypt ParallelCipher.hpp "Security/ParallelCipher.hpp"
+ */
+class ParallelCipherDecrypt : public Stream::TransformInput {
+	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> mCtx{nullptr, EVP_CIPHER_CTX_free};
+	unsigned char mIv[EVP_MAX_IV_LENGTH];
+	std::uint64_t mOffset = 0;
+	std::uint64_t mCtxOffset = 0;
+	WorkerPool* mPool = nullptr;
+	std::size_t mChunkSize = 0;
+
+	std::size_t
+	readBytes(std::byte* dest, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Input::Exception
+	{ using Stream::Input::Exception::Exception; };
+
+	/**
+	 * @param	cipher Counter mode cipher
+	 * @param	key Secret key
+	 * @param	iv Initial counter block
+	 * @param	pool Pool to run the chunks on
+	 * @param	chunkSize Reads of at least 2 * chunkSize bytes are split into chunks of chunkSize bytes
+	 */
+	ParallelCipherDecrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+			WorkerPool& pool = WorkerPool::Default(), std::size_t chunkSize = 256*1024);
+
+	ParallelCipherDecrypt(ParallelCipherDecrypt&& other) noexcept;
+
+	friend void
+	swap(ParallelCipherDecrypt& a, ParallelCipherDecrypt& b) noexcept;
+
+	ParallelCipherDecrypt&
+	operator=(ParallelCipherDecrypt&& other) noexcept;
+
+	/**
+	 * @brief	Continue decrypting from a plaintext offset
+	 * @details	The source must be positioned at the same offset of the ciphertext before the next read.
+	 */
+	void
+	seek(std::uint64_t offset) noexcept;
+};//class Security::ParallelCipherDecrypt
+
+/**
+ * @brief	Stream::Output counter mode %Cipher encryptor running on a WorkerPool
+ * @details	Output is identical to CipherEncrypt with the same cipher.
+ * @class	ParallelCipherEncrypt ParallelCipher.hpp "Security/ParallelCipher.hpp"
+ */
+class ParallelCipherEncrypt : public Stream::TransformOutput {
+	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> mCtx{nullptr, EVP_CIPHER_CTX_free};
+	unsigned char mIv[EVP_MAX_IV_LENGTH];
+	std::uint64_t mOffset = 0;
+	std::uint64_t mCtxOffset = 0;
+	WorkerPool* mPool = nullptr;
+	std::size_t mChunkSize = 0;
+
+	std::size_t
+	writeBytes(std::byte const* src, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Output::Exception
+	{ using Stream::Output::Exception::Exception; };
+
+	/**
+	 * @param	cipher Counter mode cipher
+	 * @param	key Secret key
+	 * @param	iv Initial counter block
+	 * @param	pool Pool to run the chunks on
+	 * @param	chunkSize Writes of at least 2 * chunkSize bytes are split into chunks of chunkSize bytes
+	 */
+	ParallelCipherEncrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+			WorkerPool& pool = WorkerPool::Default(), std::size_t chunkSize = 256*1024);
+
+	ParallelCipherEncrypt(ParallelCipherEncrypt&& other) noexcept;
+
+	friend void
+	swap(ParallelCipherEncrypt& a, ParallelCipherEncrypt& b) noexcept;
+
+	ParallelCipherEncrypt&
+	operator=(ParallelCipherEncrypt&& other) noexcept;
+};//class Security::ParallelCipherEncrypt
+
+/**
+ * @brief	Stream::Input / Stream::Output counter mode %Cipher decryptor and encryptor running on a WorkerPool
+ * @class	ParallelCipher ParallelCipher.hpp "Security/ParallelCipher.hpp"
+ */
+class ParallelCipher : public ParallelCipherDecrypt, public ParallelCipherEncrypt {
+	friend class ParallelCipherDecrypt;
+	friend class ParallelCipherEncrypt;
+
+	/**
+	 * @param	error Set to the OpenSSL error of the failure, the error queue of a worker is not the caller's one
+	 */
+	static bool
+	Update(EVP_CIPHER_CTX* ctx, unsigned char const* iv, std::uint64_t& ctxOffset, std::uint64_t offset,
+			WorkerPool& pool, std::size_t chunkSize, unsigned char const* src, std::size_t size, unsigned char* dest,
+			unsigned long& error);
+
+public:
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::ParallelCipher::Exception
+
+	ParallelCipher(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+			WorkerPool& pool = WorkerPool::Default(), std::size_t chunkSize = 256*1024);
+
+	ParallelCipher(EVP_CIPHER const* decCipher, Secret<> const& decKey, std::byte const* decIv,
+			EVP_CIPHER const* encCipher, Secret<> const& encKey, std::byte const* encIv,
+			WorkerPool& pool = WorkerPool::Default(), std::size_t chunkSize = 256*1024);
+};//class Security::ParallelCipher
+
+void
+swap(ParallelCipher& a, ParallelCipher& b) noexcept;
+
+std::error_code
+make_error_code(ParallelCipher::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::ParallelCipher::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_PARALLELCIPHER_HPP
@@ -0,0 +1,155 @@
+#ifndef SECURITY_RESUMABLEDIGEST_HPP
+#define SECURITY_RESUMABLEDIGEST_HPP
+
+#include "Key.hpp"
+#include <Stream/Transparent.hpp>
+#include <openssl/sha.h>
+#include <vector>
+
+namespace Security {
+
+/**
+ * @brief	Running %Digest whose internal state can be saved and restored
+ * @details	The state is written as the algorithm, the number of bytes processed, the chaining values and the bytes of
+ * 			the incomplete block. It is independent of the platform and of the OpenSSL build.
+ * @class	DigestState ResumableDigest.hpp "Security/ResumableDigest.hpp"
+ */
+class DigestState {
+public:
+	enum class Algorithm : std::uint8_t {
+		SHA1		= 1,
+		SHA224		= 2,
+		SHA256		= 3,
+		SHA384		= 4,
+		SHA512		= 5
+	};//enum class Security::DigestState::Algorithm
+
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::DigestState::Exception
+
+private:
+	Algorithm mAlgorithm{};
+	std::uint64_t mProcessed = 0;
+	union {
+		SHA_CTX sha1;
+		SHA256_CTX sha256;
+		SHA512_CTX sha512;
+	} mCtx{};
+
+public:
+	DigestState() noexcept = default;
+
+	explicit DigestState(Algorithm algorithm);
+
+	/**
+	 * @brief	Restore a state written by operator<<
+	 * @throws	Exception std::errc::bad_message if the state is malformed
+	 */
+	explicit DigestState(Stream::Input& input);
+
+	/**
+	 * @param	error Set to the OpenSSL error of the failure, the caller throws the exception of its own stream
+	 * @return	Whether the data was processed
+	 */
+	[[nodiscard]] bool
+	update(void const* data, std::size_t size, unsigned long& error);
+
+	[[nodiscard]] Algorithm
+	getAlgorithm() const noexcept;
+
+	/**
+	 * @return	Number of bytes processed so far
+	 */
+	[[nodiscard]] std::uint64_t
+	getProcessedSize() const noexcept;
+
+	[[nodiscard]] std::size_t
+	getDigestSize() const noexcept;
+
+	/**
+	 * @return	Digest of the data so far, the state is not affected
+	 */
+	[[nodiscard]] std::vector<std::byte>
+	getDigest() const;
+
+	friend Stream::Output&
+	operator<<(Stream::Output& output, DigestState const& state);
+};//class Security::DigestState
+
+/**
+ * @brief	Stream::Input resumable %Digest observer
+ * @class	ResumableDigestInput ResumableDigest.hpp "Security/ResumableDigest.hpp"
+ */
+class ResumableDigestInput : public Stream::TransparentInput {
+	DigestState mState;
+
+	std::size_t
+	readBytes(std::byte* dest, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Input::Exception
+	{ using Stream::Input::Exception::Exception; };
+
+	/**
+	 * @brief	Continue hashing from state
+	 */
+	explicit ResumableDigestInput(DigestState const& state);
+
+	ResumableDigestInput(ResumableDigestInput&& other) noexcept;
+
+	friend void
+	swap(ResumableDigestInput& a, ResumableDigestInput& b) noexcept;
+
+	ResumableDigestInput&
+	operator=(ResumableDigestInput&& other) noexcept;
+
+	[[nodiscard]] DigestState const&
+	getInputState() const noexcept;
+};//class Security::ResumableDigestInput
+
+/**
+ * @brief	Stream::Output resumable %Digest observer
+ * @class	ResumableDigestOutput ResumableDigest.hpp "Security/ResumableDigest.hpp"
+ */
+class ResumableDigestOutput : public Stream::TransparentOutput {
+	DigestState mState;
+
+	std::size_t
+	writeBytes(std::byte const* src, std::size_t size) override;
+
+public:
+	struct Exception : Stream::Output::Exception
+	{ using Stream::Output::Exception::Exception; };
+
+	/**
+	 * @brief	Continue hashing from state
+	 */
+	explicit ResumableDigestOutput(DigestState const& state);
+
+	ResumableDigestOutput(ResumableDigestOutput&& other) noexcept;
+
+	friend void
+	swap(ResumableDigestOutput& a, ResumableDigestOutput& b) noexcept;
+
+	ResumableDigestOutput&
+	operator=(ResumableDigestOutput&& other) noexcept;
+
+	[[nodiscard]] DigestState const&
+	getOutputState() const noexcept;
+};//class Security::ResumableDigestOutput
+
+std::error_code
+make_error_code(DigestState::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::DigestState::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_RESUMABLEDIGEST_HPP
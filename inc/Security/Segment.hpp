@@ -0,0 +1,188 @@
+#ifndef SECURITY_SEGMENT_HPP
+#define SECURITY_SEGMENT_HPP
+
+#include "Key.hpp"
+#include "WorkerPool.hpp"
+#include <Stream/Transform.hpp>
+
+namespace Security {
+
+/**
+ * @brief	Stream::Input segmented AEAD decryptor
+ * @details	Segments are authenticated one by one, plaintext of a segment is released only after its tag is verified.
+ * @see		Segment for the container format
+ * @class	SegmentDecrypt Segment.hpp "Security/Segment.hpp"
+ */
+class SegmentDecrypt : public Stream::TransformInput {
+	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> mCtx{nullptr, EVP_CIPHER_CTX_free};
+	std::unique_ptr<unsigned char[]> mHeader;
+	std::unique_ptr<unsigned char[]> mSegment;
+	unsigned char* mPlainCurr = nullptr;
+	unsigned char const* mPlainEnd = nullptr;
+	std::uint32_t mSegmentSize = 0;
+	std::uint32_t mMaxSegmentSize = 0;
+	std::uint32_t mSegmentFill = 0;
+	std::uint32_t mIndex = 0;
+	int mHeaderSize = 0;
+	int mHeaderFill = 0;
+	bool mLast = false;
+
+	std::size_t
+	readBytes(std::byte* dest, std::size_t size) override;
+
+	void
+	readHeader();
+
+public:
+	struct Exception : Stream::Input::Exception
+	{ using Stream::Input::Exception::Exception; };
+
+	/**
+	 * @brief	Default largest segment size accepted
+	 */
+	static constexpr std::uint32_t MaxSegmentSize = 16*1024*1024;
+
+	/**
+	 * @param	maxSegmentSize Largest segment size accepted, a segment is buffered before its tag is verified.
+	 * 			Containers with a larger one fail with std::errc::bad_message.
+	 */
+	SegmentDecrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::uint32_t maxSegmentSize = MaxSegmentSize);
+
+	SegmentDecrypt(SegmentDecrypt&& other) noexcept;
+
+	friend void
+	swap(SegmentDecrypt& a, SegmentDecrypt& b) noexcept;
+
+	SegmentDecrypt&
+	operator=(SegmentDecrypt&& other) noexcept;
+
+	/**
+	 * @brief	Continue reading from the beginning of a segment
+	 * @details	Reads the header from the source if it has not been read yet.
+	 * @return	Offset of the segment in the container, the source must be positioned there before the next read
+	 */
+	std::uint64_t
+	seek(std::uint32_t index);
+};//class Security::SegmentDecrypt
+
+/**
+ * @brief	Stream::Output segmented AEAD encryptor
+ * @details	The header is written before the first segment, the last segment is written on finalization.
+ * @see		Segment for the container format
+ * @class	SegmentEncrypt Segment.hpp "Security/Segment.hpp"
+ */
+class SegmentEncrypt : public Stream::TransformOutput {
+	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> mCtx{nullptr, EVP_CIPHER_CTX_free};
+	std::unique_ptr<unsigned char[]> mHeader;
+	std::unique_ptr<unsigned char[]> mSegment;
+	std::uint32_t mSegmentSize = 0;
+	std::uint32_t mSegmentFill = 0;
+	std::uint32_t mIndex = 0;
+	int mHeaderSize = 0;
+	bool mHeaderWritten = false;
+
+	std::size_t
+	writeBytes(std::byte const* src, std::size_t size) override;
+
+	void
+	seal(unsigned char const* src, std::uint32_t size, bool last);
+
+public:
+	struct Exception : Stream::Output::Exception
+	{ using Stream::Output::Exception::Exception; };
+
+	/**
+	 * @param	cipher AEAD cipher with at least 8 bytes iv (GCM, ChaCha20-Poly1305)
+	 * @param	key Secret key
+	 * @param	segmentSize Plaintext size of each segment except the last one
+	 */
+	SegmentEncrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::uint32_t segmentSize = 64*1024);
+
+	SegmentEncrypt(SegmentEncrypt&& other) noexcept;
+
+	friend void
+	swap(SegmentEncrypt& a, SegmentEncrypt& b) noexcept;
+
+	SegmentEncrypt&
+	operator=(SegmentEncrypt&& other) noexcept;
+
+	~SegmentEncrypt();
+
+	/**
+	 * @brief	Write the last segment
+	 */
+	void
+	finalizeEncryption();
+};//class Security::SegmentEncrypt
+
+/**
+ * @brief	Stream::Input / Stream::Output segmented AEAD decryptor and encryptor
+ * @details	Container format:
+ * 			- Header: 4 bytes big-endian plaintext segment size S, followed by a random nonce prefix of iv length - 5 bytes.
+ * 			- Segments: S bytes of ciphertext (0 to S bytes for the last one) followed by a 16 bytes tag.
+ * 			  The nonce of segment i is nonce prefix || 4 bytes big-endian i || 1 byte last segment flag,
+ * 			  the header is the additional authenticated data of every segment.
+ * 			A container always ends with a segment shorter than S, possibly empty, so truncation at a segment boundary is
+ * 			detected. Segments can be decrypted independently of each other.
+ * @class	Segment Segment.hpp "Security/Segment.hpp"
+ */
+class Segment : public SegmentDecrypt, public SegmentEncrypt {
+	friend class SegmentDecrypt;
+	friend class SegmentEncrypt;
+
+	static int
+	HeaderSize(EVP_CIPHER const* cipher);
+
+	static std::uint32_t
+	SegmentSize(unsigned char const* header) noexcept;
+
+	static void
+	Nonce(unsigned char* nonce, unsigned char const* header, int headerSize, std::uint32_t index, bool last) noexcept;
+
+	static bool
+	Open(EVP_CIPHER_CTX* ctx, unsigned char const* header, int headerSize, std::uint32_t index, bool last,
+			unsigned char const* src, std::uint32_t size, unsigned char* dest) noexcept;
+
+public:
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::Segment::Exception
+
+	/**
+	 * @brief	Plaintext size of an in memory container
+	 */
+	static std::size_t
+	PlainSize(EVP_CIPHER const* cipher, std::byte const* src, std::size_t size);
+
+	/**
+	 * @brief	Decrypt an in memory container, segments are distributed over pool
+	 * @param	dest Destination of at least PlainSize(cipher, src, size) bytes, the plaintext of a forged segment is wiped
+	 * @return	Plaintext size
+	 */
+	static std::size_t
+	Decrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* src, std::size_t size, std::byte* dest,
+			WorkerPool& pool = WorkerPool::Default());
+
+	Segment(EVP_CIPHER const* cipher, Secret<> const& key, std::uint32_t segmentSize = 64*1024);
+
+	Segment(EVP_CIPHER const* decCipher, Secret<> const& decKey,
+			EVP_CIPHER const* encCipher, Secret<> const& encKey, std::uint32_t segmentSize = 64*1024);
+};//class Security::Segment
+
+void
+swap(Segment& a, Segment& b) noexcept;
+
+std::error_code
+make_error_code(Segment::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::Segment::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_SEGMENT_HPP
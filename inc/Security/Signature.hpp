@@ -2,17 +2,21 @@
 #define SECURITY_SIGNATURE_HPP
 
 #include "Key.hpp"
+#include "WorkerPool.hpp"
 #include <Stream/Transparent.hpp>
+#include <span>
 #include <vector>
 
 namespace Security {
 
 /**
  * @brief	Stream::Input %Signature observer
+ * @details	See Signature for EdDSA keys.
  * @class	SignatureInput Signature.hpp "Security/Signature.hpp"
  */
 class SignatureInput : public Stream::TransparentInput {
 	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> mPrehashKey{nullptr, EVP_PKEY_free};
 
 	std::size_t
 	readBytes(std::byte* dest, std::size_t size) override;
@@ -37,10 +41,12 @@ public:
 
 /**
  * @brief	Stream::Output %Signature observer
+ * @details	See Signature for EdDSA keys.
  * @class	SignatureOutput Signature.hpp "Security/Signature.hpp"
  */
 class SignatureOutput : public Stream::TransparentOutput {
 	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> mPrehashKey{nullptr, EVP_PKEY_free};
 
 	std::size_t
 	writeBytes(std::byte const* src, std::size_t size) override;
@@ -68,11 +74,16 @@ public:
 
 /**
  * @brief Stream::Input / Stream::Output %Signature observer
+ * @details	OpenSSL signs with Ed25519 and Ed448 keys in one shot only. To keep memory constant the observers hash the
+ * 			data with md, SHA-512 if md is nullptr, and sign the message "Security::Signature prehash", the short name
+ * 			of the OID of md, a zero byte and the digest with such keys. Sign and Verify sign the data itself.
  * @class Signature Signature.hpp "Security/Signature.hpp"
  */
 class Signature : public SignatureInput, public SignatureOutput {
 	friend class SignatureInput;
 	friend class SignatureOutput;
+	friend class VerifyQueue;
+	friend class Verifier;
 
 	static std::size_t
 	Size(EVP_MD_CTX* ctx);
@@ -83,10 +94,36 @@ class Signature : public SignatureInput, public SignatureOutput {
 	static bool
 	Verify(EVP_MD_CTX* ctx, std::vector<std::byte> const& signature);
 
+	static std::vector<std::byte>
+	Sign(void const* data, std::size_t count, EVP_MD const* md, EVP_PKEY* signKey);
+
+	static bool
+	Verify(void const* data, std::size_t count, EVP_MD const* md, EVP_PKEY* verifyKey, std::vector<std::byte> const& signature);
+
+	/**
+	 * @brief	Result of a verification started after ERR_set_mark
+	 * @details	Errors queued since the mark are dropped, the ones of the caller are kept. A malformed signature is not an
+	 * 			error: ECDSA returns -1 without queuing one, RSA returns 0 and queues one.
+	 * @param	callerError Last error of the caller before the mark
+	 * @throws	Exception if result is negative and the verification queued an error
+	 */
+	static bool
+	Verified(int result, unsigned long callerError);
+
+	static bool
+	IsOneShot(EVP_PKEY* key) noexcept;
+
+	static std::vector<std::byte>
+	Prehash(EVP_MD_CTX* ctx);
+
 public:
 	static std::vector<std::byte>
 	Sign(void const* data, std::size_t count, EVP_MD const* md, Key const& signKey);
 
+	/**
+	 * @return	Whether signature is a valid signature of data, false if it is malformed
+	 * @throws	Exception if verification fails for another reason
+	 */
 	static bool
 	Verify(void const* data, std::size_t count, EVP_MD const* md, Key const& verifyKey, std::vector<std::byte> const& signature);
 
@@ -95,6 +132,38 @@ public:
 		enum class Code : int {};
 	};//struct Security::Signature::Exception
 
+	/**
+	 * @brief	A signed message of a batch
+	 */
+	struct Job {
+		void const* data = nullptr;
+		std::size_t count = 0;
+		Key const* verifyKey = nullptr;
+		std::byte const* signature = nullptr;
+		std::size_t signatureSize = 0;
+	};//struct Security::Signature::Job
+
+private:
+	/**
+	 * @brief	Verify job on a context of the calling thread
+	 * @details	Contexts initialized for the last 4 keys and mds of the thread are kept as templates and copied for
+	 * 			jobs with the same key and md, their keys stay referenced until they are replaced.
+	 */
+	static bool
+	Verify(Job const& job, EVP_MD const* md);
+
+public:
+	/**
+	 * @brief	Verify independent signatures on a WorkerPool
+	 * @details	The jobs are split into ranges of 64, each range is verified on one thread with a context of that thread.
+	 * 			Jobs with one of the last keys of a thread copy a context initialized once instead of initializing their
+	 * 			own. md is nullptr for Ed25519 and Ed448 keys. OpenSSL has no batch verification for them, every
+	 * 			signature is verified on its own.
+	 * @return	Element i is true if the signature of jobs[i] is valid
+	 */
+	static std::vector<bool>
+	Verify(std::span<Job const> jobs, EVP_MD const* md, WorkerPool& pool = WorkerPool::Default());
+
 	Signature(EVP_MD const* md, Key const& key);
 
 	Signature(EVP_MD const* mdIn, Key const& verifyKey, EVP_MD const* mdOut, Key const& signKey);
@@ -0,0 +1,85 @@
+#ifndef SECURITY_SIGNER_HPP
+#define SECURITY_SIGNER_HPP
+
+#include "Signature.hpp"
+
+namespace Security {
+
+/**
+ * @brief	Signs successive messages with a key and digest bound once
+ * @details	A context is initialized for the key on construction, every message is signed on a copy of it instead of
+ * 			initializing a new one. Not thread safe, copy a Signer to sign on another thread, e.g. into a thread_local.
+ * 			Signatures are identical to Signature::Sign.
+ * @class	Signer Signer.hpp "Security/Signer.hpp"
+ */
+class Signer {
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mTemplate{nullptr, EVP_MD_CTX_free};
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+	std::size_t mSize = 0;
+
+public:
+	Signer(EVP_MD const* md, Key const& signKey);
+
+	Signer(Signer const& other);
+
+	Signer(Signer&& other) noexcept;
+
+	friend void
+	swap(Signer& a, Signer& b) noexcept;
+
+	Signer&
+	operator=(Signer&& other) noexcept;
+
+	/**
+	 * @return	Maximum size of a signature
+	 */
+	[[nodiscard]] std::size_t
+	getSignatureSize() const noexcept;
+
+	/**
+	 * @brief	Write the signature of data to dest, at most getSignatureSize() bytes
+	 * @return	Size of the signature
+	 */
+	std::size_t
+	sign(void const* data, std::size_t count, std::byte* dest);
+
+	[[nodiscard]] std::vector<std::byte>
+	sign(void const* data, std::size_t count);
+};//class Security::Signer
+
+/**
+ * @brief	Verifies successive messages with a key and digest bound once
+ * @details	See Signer.
+ * @class	Verifier Signer.hpp "Security/Signer.hpp"
+ */
+class Verifier {
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mTemplate{nullptr, EVP_MD_CTX_free};
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> mCtx{nullptr, EVP_MD_CTX_free};
+
+public:
+	Verifier(EVP_MD const* md, Key const& verifyKey);
+
+	Verifier(Verifier const& other);
+
+	Verifier(Verifier&& other) noexcept;
+
+	friend void
+	swap(Verifier& a, Verifier& b) noexcept;
+
+	Verifier&
+	operator=(Verifier&& other) noexcept;
+
+	/**
+	 * @return	Whether signature is a valid signature of data, false if it is malformed
+	 * @throws	Signature::Exception if verification fails for another reason
+	 */
+	[[nodiscard]] bool
+	verify(void const* data, std::size_t count, std::byte const* signature, std::size_t signatureSize);
+
+	[[nodiscard]] bool
+	verify(void const* data, std::size_t count, std::vector<std::byte> const& signature);
+};//class Security::Verifier
+
+}//namespace Security
+
+#endif //SECURITY_SIGNER_HPP
@@ -0,0 +1,110 @@
+#ifndef SECURITY_VERIFYQUEUE_HPP
+#define SECURITY_VERIFYQUEUE_HPP
+
+#include "Signature.hpp"
+#include <chrono>
+#include <future>
+
+namespace Security {
+
+/**
+ * @brief	Asynchronous signature verification queue
+ * @details	Jobs are verified in submission order on at most getThreadCount() workers of a WorkerPool, each worker
+ * 			verifies on contexts of its own thread as the batch Signature::Verify does. The data, key and signature
+ * 			of a job must stay valid until it is completed.
+ * 			submit blocks while capacity jobs are waiting, do not submit from a worker of the same pool.
+ * 			The destructor waits for the submitted jobs.
+ * @class	VerifyQueue VerifyQueue.hpp "Security/VerifyQueue.hpp"
+ */
+class VerifyQueue {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * @brief	Called with the result of a job on the worker that verified it, exceptions thrown are ignored
+	 */
+	using Callback = std::function<void(bool)>;
+
+	/**
+	 * @brief	Jobs waiting and being verified, jobs completed with the sum and the maximum of their times from
+	 * 			submission to start (wait) and to completion (latency)
+	 */
+	struct Statistics {
+		std::size_t depth = 0;
+		std::size_t active = 0;
+		std::uint64_t completed = 0;
+		Clock::duration totalWait{};
+		Clock::duration maxWait{};
+		Clock::duration totalLatency{};
+		Clock::duration maxLatency{};
+	};//struct Security::VerifyQueue::Statistics
+
+private:
+	struct Entry {
+		Signature::Job job{};
+		std::promise<bool> promise{};
+		Callback callback{};
+		Clock::time_point submitted{};
+	};
+
+	EVP_MD const* mMd;
+	WorkerPool& mPool;
+	std::size_t mCapacity;
+	std::deque<Entry> mEntries;
+	std::size_t mWorkers = 0;
+	Statistics mStatistics;
+	mutable std::mutex mMutex;
+	std::condition_variable mSpace;
+	std::condition_variable mIdle;
+
+	void
+	enqueue(Entry entry);
+
+	void
+	work();
+
+public:
+	/**
+	 * @param	md Digest of the signatures, nullptr for EdDSA keys
+	 * @param	capacity Maximum number of waiting jobs
+	 */
+	explicit VerifyQueue(EVP_MD const* md, WorkerPool& pool = WorkerPool::Default(), std::size_t capacity = 1024);
+
+	VerifyQueue(VerifyQueue const&) = delete;
+
+	VerifyQueue&
+	operator=(VerifyQueue const&) = delete;
+
+	~VerifyQueue();
+
+	/**
+	 * @return	Future of whether the signature of job is valid, false if it is malformed
+	 */
+	[[nodiscard]] std::future<bool>
+	submit(Signature::Job const& job);
+
+	/**
+	 * @brief	Call callback with whether the signature of job is valid, false if it is malformed or verification fails
+	 */
+	void
+	submit(Signature::Job const& job, Callback callback);
+
+	/**
+	 * @brief	Wait until every submitted job is completed
+	 */
+	void
+	wait();
+
+	[[nodiscard]] std::size_t
+	getDepth() const;
+
+	[[nodiscard]] unsigned
+	getThreadCount() const noexcept;
+
+	[[nodiscard]] Statistics
+	getStatistics() const;
+};//class Security::VerifyQueue
+
+}//namespace Security
+
+#endif //SECURITY_VERIFYQUEUE_HPP
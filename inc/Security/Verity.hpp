@@ -0,0 +1,119 @@
+#ifndef SECURITY_VERITY_HPP
+#define SECURITY_VERITY_HPP
+
+#include "Key.hpp"
+#include "WorkerPool.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Security {
+
+/**
+ * @brief	Stream::Input reading a file verified block by block against a Merkle tree root
+ * @details	Reads can start anywhere, see setPosition. Only the blocks being read and the nodes on their path to the
+ * 			root are hashed, verified nodes are cached so later reads stop at the first cached node.
+ * @class	VerityInput Verity.hpp "Security/Verity.hpp"
+ */
+class VerityInput : public Stream::Input {
+	EVP_MD const* mMd = nullptr;
+	int mData = -1;
+	int mTree = -1;
+	std::size_t mBlockSize = 0;
+	std::size_t mDigestSize = 0;
+	std::uint64_t mDataSize = 0;
+	std::vector<std::uint64_t> mLevelSizes;
+	std::vector<std::uint64_t> mLevelOffsets;
+	std::unordered_map<std::uint64_t, std::vector<std::byte>> mVerified;
+	std::size_t mCacheSize = 0;
+	std::unique_ptr<std::byte[]> mBlock;
+	std::uint64_t mBlockIndex = -1;
+	std::uint64_t mPosition = 0;
+
+	std::size_t
+	readBytes(std::byte* dest, std::size_t size) override;
+
+	void
+	loadBlock(std::uint64_t index);
+
+public:
+	struct Exception : Stream::Input::Exception
+	{ using Stream::Input::Exception::Exception; };
+
+	/**
+	 * @param	md Digest of the tree
+	 * @param	data Path of the file
+	 * @param	tree Path of its sidecar written by Verity::Build
+	 * @param	root Trusted root digest
+	 * @param	cacheSize Maximum number of verified nodes kept
+	 * @throws	Verity::Exception std::errc::bad_message if the sidecar does not match the file or its block size
+	 * 			exceeds Verity::MaxBlockSize
+	 */
+	VerityInput(EVP_MD const* md, std::string const& data, std::string const& tree, std::vector<std::byte> const& root,
+			std::size_t cacheSize = 64*1024);
+
+	VerityInput(VerityInput&& other) noexcept;
+
+	friend void
+	swap(VerityInput& a, VerityInput& b) noexcept;
+
+	VerityInput&
+	operator=(VerityInput&& other) noexcept;
+
+	~VerityInput();
+
+	[[nodiscard]] std::uint64_t
+	getSize() const noexcept;
+
+	[[nodiscard]] std::uint64_t
+	getPosition() const noexcept;
+
+	/**
+	 * @brief	Continue reading at position
+	 */
+	void
+	setPosition(std::uint64_t position) noexcept;
+};//class Security::VerityInput
+
+/**
+ * @brief	Merkle tree sidecar of a file
+ * @details	The tree is the TreeHash of the file over blockSize leaves, its root is DigestTree::Compute of the file.
+ * 			The sidecar holds the block size, the digest size and the file size as big-endian integers, followed by
+ * 			the nodes of each level from the leaves up to the root. The last node of a level with an odd number of
+ * 			nodes is carried to the next level unchanged.
+ * @class	Verity Verity.hpp "Security/Verity.hpp"
+ */
+class Verity {
+public:
+	struct Exception : std::system_error {
+		using std::system_error::system_error;
+		enum class Code : int {};
+	};//struct Security::Verity::Exception
+
+	/**
+	 * @brief	Largest block size, sidecars with larger blocks are rejected before their blocks are allocated
+	 */
+	static constexpr std::size_t MaxBlockSize = 16*1024*1024;
+
+	/**
+	 * @brief	Write the sidecar of the file src to tree
+	 * @return	Root digest
+	 */
+	static std::vector<std::byte>
+	Build(EVP_MD const* md, std::string const& src, std::string const& tree, std::size_t blockSize = 4096,
+			WorkerPool& pool = WorkerPool::Default());
+};//class Security::Verity
+
+std::error_code
+make_error_code(Verity::Exception::Code e) noexcept;
+
+}//namespace Security
+
+namespace std {
+
+template <>
+struct is_error_code_enum<Security::Verity::Exception::Code> : true_type {};
+
+}//namespace std
+
+#endif //SECURITY_VERITY_HPP
@@ -0,0 +1,63 @@
+#ifndef SECURITY_WORKERPOOL_HPP
+#define SECURITY_WORKERPOOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Security {
+
+/**
+ * @brief	Fixed size pool of worker threads
+ * @class	WorkerPool WorkerPool.hpp "Security/WorkerPool.hpp"
+ */
+class WorkerPool {
+	std::vector<std::thread> mThreads;
+	std::deque<std::function<void()>> mTasks;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mStop = false;
+
+	void
+	work();
+
+public:
+	/**
+	 * @brief	Process wide pool with a thread per hardware thread
+	 */
+	static WorkerPool&
+	Default();
+
+	explicit WorkerPool(unsigned threadCount = std::thread::hardware_concurrency());
+
+	WorkerPool(WorkerPool const&) = delete;
+
+	WorkerPool&
+	operator=(WorkerPool const&) = delete;
+
+	~WorkerPool();
+
+	[[nodiscard]] unsigned
+	getThreadCount() const noexcept;
+
+	/**
+	 * @brief	Queue a task, exceptions thrown by the task are ignored
+	 */
+	void
+	submit(std::function<void()> task);
+
+	/**
+	 * @brief	Call task(0) ... task(count - 1) on the workers and the calling thread
+	 * @details	Returns when all calls are completed, the first exception thrown by a call is rethrown.
+	 * 			Can be called from a worker thread.
+	 */
+	void
+	run(std::size_t count, std::function<void(std::size_t)> const& task);
+};//class Security::WorkerPool
+
+}//namespace Security
+
+#endif //SECURITY_WORKERPOOL_HPP
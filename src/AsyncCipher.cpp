@@ -0,0 +1,184 @@
+#include "Security/AsyncCipher.hpp"
+#include "Security/Cipher.hpp"
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <openssl/err.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <utility>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+#define Expect1(x) if (1 != x) throw Exception(static_cast<Cipher::Exception::Code>(ERR_peek_last_error()))
+
+namespace Security {
+
+AsyncCipherEncrypt::AsyncCipherEncrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+		std::size_t bufferSize)
+		: mCtx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free)
+		, mBufferSize(bufferSize ? bufferSize : 1)
+		, mExtSize(EVP_CIPHER_block_size(cipher) - 1)
+		, mTagSize(Cipher::TagSize(cipher))
+{
+	ExpectAllocated(mCtx);
+	Expect1(EVP_EncryptInit_ex(mCtx.get(), cipher, nullptr, key.get(), reinterpret_cast<unsigned char const*>(iv)));
+	for (auto& buffer : mBuffers)
+		buffer.reset(new std::byte[mBufferSize]);
+	for (auto& output : mOutputs)
+		output.reset(new std::byte[mBufferSize + mExtSize]);
+
+	mWorker = std::thread{&AsyncCipherEncrypt::work, this};
+	pthread_setname_np(mWorker.native_handle(), "CipherEncrypt");
+	pthread_getcpuclockid(mWorker.native_handle(), &mWorkerClock);
+}
+
+AsyncCipherEncrypt::~AsyncCipherEncrypt()
+{
+	try {
+		finalizeEncryption();
+	} catch (std::exception const& exc) {
+		::write(STDERR_FILENO, exc.what(), std::strlen(exc.what()));
+	}
+	{
+		std::lock_guard lock{mMutex};
+		mStop = true;
+	}
+	mCondition.notify_all();
+	mWorker.join();
+}
+
+void
+AsyncCipherEncrypt::work()
+{
+	std::unique_lock lock{mMutex};
+	while (true) {
+		mCondition.wait(lock, [this] { return mStop || mBusy; });
+		if (!mBusy)
+			return;
+
+		auto const* src = reinterpret_cast<unsigned char const*>(mBuffers[mCurrent ^ 1].get());
+		auto* dest = reinterpret_cast<unsigned char*>(mOutputs[mCurrent ^ 1].get());
+		std::size_t size = mSubmitted;
+		lock.unlock();
+		int outl = 0;
+		try {
+			Expect1(EVP_EncryptUpdate(mCtx.get(), dest, &outl, src, static_cast<int>(size)));
+		} catch (...) {
+			lock.lock();
+			mError = std::current_exception();
+			lock.unlock();
+		}
+		lock.lock();
+		mEncrypted = outl;
+		mBusy = false;
+		mCondition.notify_all();
+	}
+}
+
+void
+AsyncCipherEncrypt::wait()
+{
+	std::unique_lock lock{mMutex};
+	mCondition.wait(lock, [this] { return !mBusy; });
+	if (mError)
+		std::rethrow_exception(std::exchange(mError, nullptr));
+}
+
+void
+AsyncCipherEncrypt::forward(std::byte const* src, std::size_t size)
+{
+	if (!size)
+		return;
+	provideSpace(size);
+	std::memcpy(getSpace(), src, size);
+	advanceSpace(size);
+}
+
+void
+AsyncCipherEncrypt::submit()
+{
+	wait();
+	std::size_t encrypted;
+	{
+		std::lock_guard lock{mMutex};
+		encrypted = std::exchange(mEncrypted, 0);
+		mSubmitted = mFill;
+		mBusy = true;
+		mCurrent ^= 1;
+	}
+	mCondition.notify_all();
+	mFill = 0;
+	// the previous buffer goes to the sink while the worker encrypts this one
+	forward(mOutputs[mCurrent].get(), encrypted);
+}
+
+void
+AsyncCipherEncrypt::drain()
+{
+	wait();
+	forward(mOutputs[mCurrent ^ 1].get(), std::exchange(mEncrypted, 0));
+}
+
+std::size_t
+AsyncCipherEncrypt::writeBytes(std::byte const* src, std::size_t size)
+{
+	if (mFinalized)
+		throw Exception(Stream::Output::Exception::Code::Uninitialized);
+
+	size = std::min(size, mBufferSize - mFill);
+	std::memcpy(mBuffers[mCurrent].get() + mFill, src, size);
+	if ((mFill += size) == mBufferSize)
+		submit();
+	return size;
+}
+
+Stream::Output&
+AsyncCipherEncrypt::flush()
+{
+	if (mFill)
+		submit();
+	drain();
+	return Stream::TransformOutput::flush();
+}
+
+void
+AsyncCipherEncrypt::updateAAD(void const* aad, std::size_t size)
+{
+	if (mFinalized)
+		throw Exception(Stream::Output::Exception::Code::Uninitialized);
+	if (!mTagSize)
+		throw Exception(std::make_error_code(std::errc::operation_not_supported));
+
+	drain();
+	int outl;
+	Expect1(EVP_EncryptUpdate(mCtx.get(), nullptr, &outl, static_cast<unsigned char const*>(aad), static_cast<int>(size)));
+}
+
+void
+AsyncCipherEncrypt::finalizeEncryption()
+{
+	if (mFinalized)
+		return;
+	if (mFill)
+		submit();
+	drain();
+
+	mFinalized = true;
+	provideSpace(mExtSize + 1 + mTagSize);
+	int outl;
+	Expect1(EVP_EncryptFinal_ex(mCtx.get(), reinterpret_cast<unsigned char*>(getSpace()), &outl));
+	if (mTagSize)
+		Expect1(EVP_CIPHER_CTX_ctrl(mCtx.get(), EVP_CTRL_AEAD_GET_TAG, mTagSize, getSpace() + outl));
+	advanceSpace(outl + mTagSize);
+}
+
+std::chrono::nanoseconds
+AsyncCipherEncrypt::getWorkerCpuTime() const
+{
+	timespec time{};
+	if (clock_gettime(mWorkerClock, &time))
+		throw std::system_error(errno, std::system_category());
+	return std::chrono::seconds{time.tv_sec} + std::chrono::nanoseconds{time.tv_nsec};
+}
+
+}//namespace Security
@@ -0,0 +1,347 @@
+#include "Security/Checkpoint.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <openssl/err.h>
+#include <unistd.h>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+#define Expect1(x) if (1 != x) throw Exception(static_cast<Checkpoint::Exception::Code>(ERR_peek_last_error()))
+#define HEADER_SIZE 4
+#define FRAME_HEADER_SIZE 5
+#define MAX_SIGNATURE_SIZE (16 * 1024)
+
+namespace Security {
+
+namespace {
+
+enum class Frame : std::uint8_t {
+	Data = 0,
+	Signature = 1
+};
+
+void
+PutFrameHeader(std::byte* p, Frame type, std::uint32_t size) noexcept
+{
+	p[0] = static_cast<std::byte>(type);
+	p[1] = static_cast<std::byte>(size >> 24);
+	p[2] = static_cast<std::byte>(size >> 16);
+	p[3] = static_cast<std::byte>(size >> 8);
+	p[4] = static_cast<std::byte>(size);
+}
+
+std::uint32_t
+GetUInt32(std::byte const* p) noexcept
+{
+	return static_cast<std::uint32_t>(p[0]) << 24 | static_cast<std::uint32_t>(p[1]) << 16
+			| static_cast<std::uint32_t>(p[2]) << 8 | static_cast<std::uint32_t>(p[3]);
+}
+
+}//namespace
+
+CheckpointInput::CheckpointInput(EVP_MD const* md, Key const& verifyKey, std::uint32_t maxInterval)
+		: mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mVerifier(std::in_place, md, verifyKey)
+		, mMaxInterval(maxInterval)
+{
+	ExpectAllocated(mCtx);
+	Expect1(EVP_DigestInit_ex(mCtx.get(), Checkpoint::ChainDigest(md), nullptr));
+}
+
+CheckpointInput::CheckpointInput(CheckpointInput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(CheckpointInput& a, CheckpointInput& b) noexcept
+{
+	swap(static_cast<Stream::TransformInput&>(a), static_cast<Stream::TransformInput&>(b));
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mVerifier, b.mVerifier);
+	std::swap(a.mData, b.mData);
+	std::swap(a.mPlainCurr, b.mPlainCurr);
+	std::swap(a.mPlainEnd, b.mPlainEnd);
+	std::swap(a.mInterval, b.mInterval);
+	std::swap(a.mMaxInterval, b.mMaxInterval);
+	std::swap(a.mFill, b.mFill);
+	std::swap(a.mCount, b.mCount);
+}
+
+CheckpointInput&
+CheckpointInput::operator=(CheckpointInput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+void
+CheckpointInput::readFrame(std::byte* dest, std::size_t size)
+{
+	try {
+		while (size) {
+			std::size_t n = provideSomeData(size);
+			std::memcpy(dest, getData(), n);
+			advanceData(n);
+			dest += n;
+			size -= n;
+		}
+	} catch (Stream::Input::Exception const& exc) {
+		if (exc.code() != std::make_error_code(std::errc::no_message_available))
+			throw;
+		throw Exception(std::make_error_code(std::errc::bad_message)); // truncated
+	}
+}
+
+void
+CheckpointInput::readHeader()
+{
+	std::byte header[HEADER_SIZE];
+	readFrame(header, HEADER_SIZE);
+	mInterval = GetUInt32(header);
+	// the header is authenticated by the first checkpoint only, the buffer is allocated before
+	if (!mInterval || mInterval > mMaxInterval)
+		throw Exception(std::make_error_code(std::errc::bad_message));
+	mData.reset(new std::byte[mInterval]);
+	mPlainEnd = mPlainCurr = mData.get();
+	unsigned long error;
+	if (!Checkpoint::Start(mCtx.get(), header, error))
+		throw Exception(static_cast<Checkpoint::Exception::Code>(error));
+}
+
+std::size_t
+CheckpointInput::readBytes(std::byte* dest, std::size_t size)
+{
+	if (mPlainCurr != mPlainEnd) { // there is verified data
+		if (size > static_cast<std::size_t>(mPlainEnd - mPlainCurr))
+			size = mPlainEnd - mPlainCurr;
+		std::memcpy(dest, mPlainCurr, size);
+		mPlainCurr += size;
+		return size;
+	}
+
+	try {
+		provideSomeData(1);
+	} catch (Stream::Input::Exception const& exc) {
+		// the stream may end only before the header or after a checkpoint
+		if (exc.code() != std::make_error_code(std::errc::no_message_available) || !mFill)
+			throw;
+		throw Exception(std::make_error_code(std::errc::bad_message));
+	}
+
+	if (!mInterval)
+		readHeader();
+
+	std::byte frame[FRAME_HEADER_SIZE];
+	readFrame(frame, FRAME_HEADER_SIZE);
+	std::uint32_t frameSize = GetUInt32(frame + 1);
+	switch (static_cast<Frame>(frame[0])) {
+		case Frame::Data:
+			if (!frameSize || frameSize > mInterval - mFill)
+				throw Exception(std::make_error_code(std::errc::bad_message));
+			readFrame(mData.get() + mFill, frameSize);
+			Expect1(EVP_DigestUpdate(mCtx.get(), mData.get() + mFill, frameSize));
+			mFill += frameSize;
+			break;
+		case Frame::Signature: {
+			if (!frameSize || frameSize > MAX_SIGNATURE_SIZE)
+				throw Exception(std::make_error_code(std::errc::bad_message));
+			std::byte signature[MAX_SIGNATURE_SIZE];
+			readFrame(signature, frameSize);
+			std::byte chain[EVP_MAX_MD_SIZE];
+			std::size_t chainSize;
+			unsigned long error;
+			if (!Checkpoint::Next(mCtx.get(), chain, chainSize, error))
+				throw Exception(static_cast<Checkpoint::Exception::Code>(error));
+			if (!mVerifier->verify(chain, chainSize, signature, frameSize))
+				throw Exception(std::make_error_code(std::errc::bad_message));
+			mPlainEnd = (mPlainCurr = mData.get()) + mFill;
+			mFill = 0;
+			++mCount;
+			break;
+		}
+		default:
+			throw Exception(std::make_error_code(std::errc::bad_message));
+	}
+	return 0; // try again to read verified data
+}
+
+std::uint64_t
+CheckpointInput::getCheckpointCount() const noexcept
+{ return mCount; }
+
+CheckpointOutput::CheckpointOutput(EVP_MD const* md, Key const& signKey, std::uint32_t interval,
+		std::chrono::milliseconds period)
+		: mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mSigner(std::in_place, md, signKey)
+		, mPeriod(period)
+		, mLast(std::chrono::steady_clock::now())
+		, mInterval(interval)
+{
+	ExpectAllocated(mCtx);
+	if (!interval || mSigner->getSignatureSize() > MAX_SIGNATURE_SIZE)
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
+	Expect1(EVP_DigestInit_ex(mCtx.get(), Checkpoint::ChainDigest(md), nullptr));
+}
+
+CheckpointOutput::CheckpointOutput(CheckpointOutput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(CheckpointOutput& a, CheckpointOutput& b) noexcept
+{
+	swap(static_cast<Stream::TransformOutput&>(a), static_cast<Stream::TransformOutput&>(b));
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mSigner, b.mSigner);
+	std::swap(a.mPeriod, b.mPeriod);
+	std::swap(a.mLast, b.mLast);
+	std::swap(a.mInterval, b.mInterval);
+	std::swap(a.mFill, b.mFill);
+	std::swap(a.mCount, b.mCount);
+	std::swap(a.mHeaderWritten, b.mHeaderWritten);
+}
+
+CheckpointOutput&
+CheckpointOutput::operator=(CheckpointOutput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+void
+CheckpointOutput::writeHeader()
+{
+	provideSpace(HEADER_SIZE);
+	auto* header = getSpace();
+	header[0] = static_cast<std::byte>(mInterval >> 24);
+	header[1] = static_cast<std::byte>(mInterval >> 16);
+	header[2] = static_cast<std::byte>(mInterval >> 8);
+	header[3] = static_cast<std::byte>(mInterval);
+	unsigned long error;
+	if (!Checkpoint::Start(mCtx.get(), header, error))
+		throw Exception(static_cast<Checkpoint::Exception::Code>(error));
+	advanceSpace(HEADER_SIZE);
+	mHeaderWritten = true;
+}
+
+std::size_t
+CheckpointOutput::writeBytes(std::byte const* src, std::size_t size)
+{
+	if (!mSigner)
+		throw Exception(Stream::Output::Exception::Code::Uninitialized);
+
+	if (!mHeaderWritten)
+		writeHeader();
+
+	if (size > mInterval - mFill)
+		size = mInterval - mFill;
+	provideSpace(FRAME_HEADER_SIZE + size);
+	PutFrameHeader(getSpace(), Frame::Data, static_cast<std::uint32_t>(size));
+	std::memcpy(getSpace() + FRAME_HEADER_SIZE, src, size);
+	advanceSpace(FRAME_HEADER_SIZE + size);
+	Expect1(EVP_DigestUpdate(mCtx.get(), src, size));
+	mFill += static_cast<std::uint32_t>(size);
+
+	if (mFill == mInterval
+			|| (mPeriod != std::chrono::steady_clock::duration::zero() && std::chrono::steady_clock::now() - mLast >= mPeriod))
+		checkpoint();
+	return size;
+}
+
+void
+CheckpointOutput::checkpoint()
+{
+	mLast = std::chrono::steady_clock::now();
+	if (!mFill)
+		return;
+
+	std::byte chain[EVP_MAX_MD_SIZE];
+	std::size_t chainSize;
+	unsigned long error;
+	if (!Checkpoint::Next(mCtx.get(), chain, chainSize, error))
+		throw Exception(static_cast<Checkpoint::Exception::Code>(error));
+	provideSpace(FRAME_HEADER_SIZE + mSigner->getSignatureSize());
+	auto size = mSigner->sign(chain, chainSize, getSpace() + FRAME_HEADER_SIZE);
+	PutFrameHeader(getSpace(), Frame::Signature, static_cast<std::uint32_t>(size));
+	advanceSpace(FRAME_HEADER_SIZE + size);
+	mFill = 0;
+	++mCount;
+}
+
+CheckpointOutput::~CheckpointOutput()
+{
+	try {
+		if (mSigner)
+			checkpoint();
+	} catch (std::exception const& exc) {
+		::write(STDERR_FILENO, exc.what(), std::strlen(exc.what()));
+	}
+}
+
+std::uint64_t
+CheckpointOutput::getCheckpointCount() const noexcept
+{ return mCount; }
+
+EVP_MD const*
+Checkpoint::ChainDigest(EVP_MD const* md) noexcept
+{ return md ? md : EVP_sha512(); }
+
+bool
+Checkpoint::Start(EVP_MD_CTX* ctx, std::byte const* header, unsigned long& error)
+{
+	constexpr std::string_view prefix{"Security::Checkpoint"};
+	std::byte chain[EVP_MAX_MD_SIZE];
+	std::size_t size;
+	if (1 == EVP_DigestUpdate(ctx, prefix.data(), prefix.size())
+			&& 1 == EVP_DigestUpdate(ctx, header, HEADER_SIZE))
+		return Next(ctx, chain, size, error);
+	error = ERR_peek_last_error();
+	return false;
+}
+
+bool
+Checkpoint::Next(EVP_MD_CTX* ctx, std::byte* chain, std::size_t& size, unsigned long& error)
+{
+	unsigned chainSize;
+	if (1 == EVP_DigestFinal_ex(ctx, reinterpret_cast<unsigned char*>(chain), &chainSize)
+			&& 1 == EVP_DigestInit_ex(ctx, nullptr, nullptr)
+			&& 1 == EVP_DigestUpdate(ctx, chain, chainSize)) {
+		size = chainSize;
+		return true;
+	}
+	error = ERR_peek_last_error();
+	return false;
+}
+
+Checkpoint::Checkpoint(EVP_MD const* md, Key const& key, std::uint32_t interval, std::chrono::milliseconds period)
+		: Checkpoint(md, key, md, key, interval, period)
+{}
+
+Checkpoint::Checkpoint(EVP_MD const* mdIn, Key const& verifyKey, EVP_MD const* mdOut, Key const& signKey,
+		std::uint32_t interval, std::chrono::milliseconds period)
+		: CheckpointInput(mdIn, verifyKey, std::max(interval, CheckpointInput::MaxInterval))
+		, CheckpointOutput(mdOut, signKey, interval, period)
+{}
+
+void
+swap(Checkpoint& a, Checkpoint& b) noexcept
+{
+	swap(static_cast<CheckpointInput&>(a), static_cast<CheckpointInput&>(b));
+	swap(static_cast<CheckpointOutput&>(a), static_cast<CheckpointOutput&>(b));
+}
+
+std::error_code
+make_error_code(Checkpoint::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::Checkpoint"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
@@ -0,0 +1,211 @@
+#include "Security/ChunkDigest.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <new>
+#include <openssl/err.h>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+#define Expect1(x) if (1 != x) throw ChunkDigest::Exception(static_cast<ChunkDigest::Exception::Code>(ERR_peek_last_error()))
+
+namespace Security {
+
+namespace {
+
+// fixed pseudo random values (splitmix64), boundaries must not change between builds
+constexpr std::array<std::uint64_t, 256> Gear = [] {
+	std::array<std::uint64_t, 256> gear{};
+	std::uint64_t state = 0x5365637572697479;
+	for (auto& g : gear) {
+		std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+		g = z ^ (z >> 31);
+	}
+	return gear;
+}();
+
+}//namespace
+
+ContentChunker::ContentChunker(EVP_MD const* md, Callback callback, std::size_t averageSize)
+		: mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mCallback(std::move(callback))
+{
+	if (averageSize < 64)
+		throw ChunkDigest::Exception(std::make_error_code(std::errc::invalid_argument));
+	ExpectAllocated(mCtx);
+	Expect1(EVP_DigestInit_ex(mCtx.get(), md, nullptr));
+
+	int bits = std::bit_width(averageSize) - 1;
+	mAverageSize = std::size_t{1} << bits;
+	mMinSize = mAverageSize / 4;
+	mMaxSize = mAverageSize * 8;
+	// the highest bits of the Gear hash depend on the last 64 bytes
+	mMaskS = ~std::uint64_t{0} << (64 - (bits + 1));
+	mMaskL = ~std::uint64_t{0} << (64 - (bits - 1));
+}
+
+bool
+ContentChunker::cut(unsigned long& error)
+{
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int digestSize = 0;
+	if (1 != EVP_DigestFinal_ex(mCtx.get(), digest, &digestSize) || 1 != EVP_DigestInit_ex(mCtx.get(), nullptr, nullptr)) {
+		error = ERR_peek_last_error();
+		return false;
+	}
+
+	std::uint64_t offset = mOffset;
+	std::size_t size = mSize;
+	mOffset += mSize;
+	mSize = 0;
+	mHash = 0;
+	mCallback(offset, size, std::span<std::byte const>(reinterpret_cast<std::byte const*>(digest), digestSize));
+	return true;
+}
+
+bool
+ContentChunker::update(void const* data, std::size_t size, unsigned long& error)
+{
+	auto const* src = static_cast<unsigned char const*>(data);
+	while (size) {
+		std::size_t i = mSize < mMinSize ? std::min(size, mMinSize - mSize) : 0;
+		bool boundary = false;
+		for (; i < size; ++i) {
+			std::size_t position = mSize + i;
+			if (position == mMaxSize) {
+				boundary = true;
+				break;
+			}
+			mHash = (mHash << 1) + Gear[src[i]];
+			if (!(mHash & (position < mAverageSize ? mMaskS : mMaskL))) {
+				boundary = true;
+				++i;
+				break;
+			}
+		}
+
+		if (1 != EVP_DigestUpdate(mCtx.get(), src, i)) {
+			error = ERR_peek_last_error();
+			return false;
+		}
+		mSize += i;
+		src += i;
+		size -= i;
+		if (boundary && !cut(error))
+			return false;
+	}
+	return true;
+}
+
+bool
+ContentChunker::finalize(unsigned long& error)
+{ return !mSize || cut(error); }
+
+ChunkDigestInput::ChunkDigestInput(EVP_MD const* md, ContentChunker::Callback callback, std::size_t averageSize)
+		: mChunker(md, std::move(callback), averageSize)
+{}
+
+ChunkDigestInput::ChunkDigestInput(ChunkDigestInput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(ChunkDigestInput& a, ChunkDigestInput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentInput&>(a), static_cast<Stream::TransparentInput&>(b));
+	std::swap(a.mChunker, b.mChunker);
+}
+
+ChunkDigestInput&
+ChunkDigestInput::operator=(ChunkDigestInput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+ChunkDigestInput::readBytes(std::byte* dest, std::size_t size)
+{
+	size = getSome(dest, size);
+	unsigned long error;
+	if (!mChunker.update(dest, size, error))
+		throw Exception(static_cast<ChunkDigest::Exception::Code>(error));
+	return size;
+}
+
+void
+ChunkDigestInput::finalizeInputChunk()
+{
+	unsigned long error;
+	if (!mChunker.finalize(error))
+		throw Exception(static_cast<ChunkDigest::Exception::Code>(error));
+}
+
+ChunkDigestOutput::ChunkDigestOutput(EVP_MD const* md, ContentChunker::Callback callback, std::size_t averageSize)
+		: mChunker(md, std::move(callback), averageSize)
+{}
+
+ChunkDigestOutput::ChunkDigestOutput(ChunkDigestOutput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(ChunkDigestOutput& a, ChunkDigestOutput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentOutput&>(a), static_cast<Stream::TransparentOutput&>(b));
+	std::swap(a.mChunker, b.mChunker);
+}
+
+ChunkDigestOutput&
+ChunkDigestOutput::operator=(ChunkDigestOutput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+ChunkDigestOutput::writeBytes(std::byte const* src, std::size_t size)
+{
+	size = putSome(src, size);
+	unsigned long error;
+	if (!mChunker.update(src, size, error))
+		throw Exception(static_cast<ChunkDigest::Exception::Code>(error));
+	return size;
+}
+
+void
+ChunkDigestOutput::finalizeOutputChunk()
+{
+	unsigned long error;
+	if (!mChunker.finalize(error))
+		throw Exception(static_cast<ChunkDigest::Exception::Code>(error));
+}
+
+ChunkDigest::ChunkDigest(EVP_MD const* md, ContentChunker::Callback inCallback, ContentChunker::Callback outCallback,
+		std::size_t averageSize)
+		: ChunkDigestInput(md, std::move(inCallback), averageSize)
+		, ChunkDigestOutput(md, std::move(outCallback), averageSize)
+{}
+
+void
+swap(ChunkDigest& a, ChunkDigest& b) noexcept
+{
+	swap(static_cast<ChunkDigestInput&>(a), static_cast<ChunkDigestInput&>(b));
+	swap(static_cast<ChunkDigestOutput&>(a), static_cast<ChunkDigestOutput&>(b));
+}
+
+std::error_code
+make_error_code(ChunkDigest::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::ChunkDigest"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
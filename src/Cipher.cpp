@@ -1,8 +1,16 @@
 #include "Security/Cipher.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <new>
+#include <openssl/crypto.h>
 #include <openssl/err.h>
 #include <openssl/rand.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define ExpectAllocated(x) if (!x) throw std::bad_alloc()
 #define Expect1(x) if (1 != x) throw Exception(static_cast<Cipher::Exception::Code>(ERR_peek_last_error()))
@@ -27,6 +35,17 @@ swap(CipherDecrypt& a, CipherDecrypt& b) noexcept
 	std::swap(a.mTempBeg, b.mTempBeg);
 	std::swap(a.mTempCurr, b.mTempCurr);
 	std::swap(a.mTempEnd, b.mTempEnd);
+	std::swap(a.mTempSize, b.mTempSize);
+	std::swap(a.mHeldBeg, b.mHeldBeg);
+	std::swap(a.mHeldSize, b.mHeldSize);
+	std::swap(a.mHeldFill, b.mHeldFill);
+	std::swap(a.mReadAheadSize, b.mReadAheadSize);
+	std::swap(a.mTag, b.mTag);
+	std::swap(a.mIv, b.mIv);
+	std::swap(a.mTagSize, b.mTagSize);
+	std::swap(a.mTagFill, b.mTagFill);
+	std::swap(a.mInputSize, b.mInputSize);
+	std::swap(a.mFinalized, b.mFinalized);
 	std::swap(a.mFinalizeWhenNoData, b.mFinalizeWhenNoData);
 }
 
@@ -41,7 +60,10 @@ void
 CipherDecrypt::init(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv)
 {
 	if (EVP_CIPHER_block_size(cipher) > 1)
-		mTempBeg.reset(new unsigned char[2*EVP_CIPHER_block_size(cipher)]);
+		reserveTemp(2*EVP_CIPHER_block_size(cipher));
+	mTagSize = Cipher::TagSize(cipher);
+	if (iv)
+		std::memcpy(mIv, iv, EVP_CIPHER_iv_length(cipher));
 
 	/*
 	if (EVP_CIPHER_mode(cipher) == EVP_CIPH_WRAP_MODE)
@@ -51,11 +73,40 @@ CipherDecrypt::init(EVP_CIPHER const* cipher, Secret<> const& key, std::byte con
 	Expect1(EVP_DecryptInit_ex(mCtx.get(), cipher, nullptr, key.get(), reinterpret_cast<unsigned char const*>(iv)));
 }
 
+void
+CipherDecrypt::reserveTemp(std::size_t size)
+{
+	std::size_t pending = mTempEnd - mTempCurr;
+	if (size > mTempSize) {
+		std::unique_ptr<unsigned char, decltype(&std::free)> temp{
+				static_cast<unsigned char*>(std::aligned_alloc(64, (size + 63) & ~std::size_t{63})), std::free};
+		ExpectAllocated(temp);
+		if (pending)
+			std::memcpy(temp.get(), mTempCurr, pending);
+		mTempBeg = std::move(temp);
+		mTempSize = size;
+	} else if (pending && mTempCurr != mTempBeg.get())
+		std::memmove(mTempBeg.get(), mTempCurr, pending);
+	mTempEnd = (mTempCurr = mTempBeg.get()) + pending;
+}
+
+void
+CipherDecrypt::updateAAD(void const* aad, std::size_t size)
+{
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()) || mFinalized)
+		throw Exception(Stream::Input::Exception::Code::Uninitialized);
+	if (!mTagSize)
+		throw Exception(std::make_error_code(std::errc::operation_not_supported));
+
+	int outl;
+	Expect1(EVP_DecryptUpdate(mCtx.get(), nullptr, &outl, static_cast<unsigned char const*>(aad), static_cast<int>(size)));
+}
+
 std::size_t
 CipherDecrypt::readBytes(std::byte* dest, std::size_t size)
 {
 	if (mTempCurr != mTempEnd) { // there is decrypted data
-		if (size > mTempEnd - mTempCurr)
+		if (size > static_cast<std::size_t>(mTempEnd - mTempCurr))
 			size = mTempEnd - mTempCurr;
 		std::memcpy(dest, mTempCurr, size);
 		mTempCurr += size;
@@ -64,18 +115,26 @@ CipherDecrypt::readBytes(std::byte* dest, std::size_t size)
 
 	if (!EVP_CIPHER_CTX_cipher(mCtx.get()))
 		throw Exception(Stream::Input::Exception::Code::Uninitialized);
+	if (mFinalized)
+		throw Exception(std::make_error_code(std::errc::no_message_available));
 
-	if (EVP_CIPHER_CTX_block_size(mCtx.get()) > 1) {
-		if (size >= 2 * EVP_CIPHER_CTX_block_size(mCtx.get())) {
-			size /= EVP_CIPHER_CTX_block_size(mCtx.get());
-			size = (size - 1) * EVP_CIPHER_CTX_block_size(mCtx.get());
-		}
-		else {
-			size = EVP_CIPHER_CTX_block_size(mCtx.get());
-			dest = reinterpret_cast<std::byte*>(mTempBeg.get());
-		}
+	if (!mInputSize) {
+		finalizeDecryption();
+		return 0; // try again to read from mTemp
 	}
 
+	std::size_t blockSize = EVP_CIPHER_CTX_block_size(mCtx.get());
+	if (size < mReadAheadSize || (blockSize > 1 && size < 2 * blockSize)) {
+		// a block cipher may release one more block than it is given
+		size = blockSize > 1 ? mTempSize - blockSize : mReadAheadSize;
+		dest = reinterpret_cast<std::byte*>(mTempBeg.get());
+	} else if (blockSize > 1) {
+		size /= blockSize;
+		size = (size - 1) * blockSize;
+	}
+	if (size > mInputSize)
+		size = mInputSize;
+
 	if (mFinalizeWhenNoData) {
 		try {
 			size = provideSomeData(size);
@@ -87,36 +146,160 @@ CipherDecrypt::readBytes(std::byte* dest, std::size_t size)
 		}
 	} else
 		size = provideSomeData(size);
+	mInputSize -= size;
 
 	int outl;
-	Expect1(EVP_DecryptUpdate(mCtx.get(), reinterpret_cast<unsigned char*>(dest), &outl,
-			reinterpret_cast<unsigned char const*>(getData()), static_cast<int>(size)));
+	if (mTagSize) { // the last mTagSize bytes seen so far may be the tag
+		auto const* data = reinterpret_cast<unsigned char const*>(getData());
+		if (mTagFill + size <= static_cast<std::size_t>(mTagSize)) {
+			std::memcpy(mTag + mTagFill, data, size);
+			mTagFill += static_cast<int>(size);
+			advanceData(size);
+			return 0; // try again to fill mTag
+		}
+
+		// the plaintext held back is not the last one, release it and hold this one back until the tag is verified
+		std::swap(mTempBeg, mHeldBeg);
+		std::swap(mTempSize, mHeldSize);
+		mTempEnd = (mTempCurr = mTempBeg.get()) + mHeldFill;
+		mHeldFill = 0;
+
+		std::size_t outSize = mTagFill + size - mTagSize;
+		if (outSize > mHeldSize) {
+			mHeldBeg.reset(static_cast<unsigned char*>(std::aligned_alloc(64, (outSize + 63) & ~std::size_t{63})));
+			ExpectAllocated(mHeldBeg);
+			mHeldSize = outSize;
+		}
+		auto* out = mHeldBeg.get();
+		std::size_t fromTag = std::min(outSize, static_cast<std::size_t>(mTagFill));
+		if (fromTag)
+			Expect1(EVP_DecryptUpdate(mCtx.get(), out, &outl, mTag, static_cast<int>(fromTag)));
+		if (outSize > fromTag)
+			Expect1(EVP_DecryptUpdate(mCtx.get(), out + fromTag, &outl, data, static_cast<int>(outSize - fromTag)));
+
+		std::memmove(mTag, mTag + fromTag, mTagFill - fromTag);
+		std::memcpy(mTag + mTagFill - fromTag, data + outSize - fromTag, size - (outSize - fromTag));
+		mTagFill = mTagSize;
+		mHeldFill = outSize;
+		advanceData(size);
+		if (!mInputSize)
+			finalizeDecryption();
+		return 0; // try again to read from mTemp
+	} else
+		Expect1(EVP_DecryptUpdate(mCtx.get(), reinterpret_cast<unsigned char*>(dest), &outl,
+				reinterpret_cast<unsigned char const*>(getData()), static_cast<int>(size)));
 
 	advanceData(size);
 	if (dest == reinterpret_cast<std::byte*>(mTempBeg.get())) {
 		mTempEnd = (mTempCurr = mTempBeg.get()) + outl;
-		return 0; // try again to read from mTemp
+		outl = 0; // try again to read from mTemp
 	}
+	if (!mInputSize)
+		finalizeDecryption();
 	return outl;
 }
 
 void
 CipherDecrypt::finalizeDecryption()
 {
-	if (EVP_CIPHER_CTX_cipher(mCtx.get())) {
+	if (EVP_CIPHER_CTX_cipher(mCtx.get()) && !mFinalized) {
 		if (EVP_CIPHER_CTX_block_size(mCtx.get()) > 1) {
+			// keep the plaintext that has been read ahead
+			reserveTemp(mTempEnd - mTempCurr + EVP_CIPHER_CTX_block_size(mCtx.get()));
+			int outl;
+			Expect1(EVP_DecryptFinal_ex(mCtx.get(), mTempCurr + (mTempEnd - mTempCurr), &outl));
+			mTempEnd += outl;
+		} else if (mTagSize) {
+			while (mTagFill < mTagSize) { // plaintext has been read exactly, the tag is still in the source
+				std::size_t size = provideSomeData(mTagSize - mTagFill);
+				std::memcpy(mTag + mTagFill, getData(), size);
+				mTagFill += static_cast<int>(size);
+				advanceData(size);
+			}
+			Expect1(EVP_CIPHER_CTX_ctrl(mCtx.get(), EVP_CTRL_AEAD_SET_TAG, mTagSize, mTag));
 			int outl;
-			Expect1(EVP_DecryptFinal_ex(mCtx.get(), mTempBeg.get(), &outl));
-			mTempEnd = (mTempCurr = mTempBeg.get()) + outl;
+			if (1 != EVP_DecryptFinal_ex(mCtx.get(), mTag, &outl)) {
+				OPENSSL_cleanse(mHeldBeg.get(), mHeldFill);
+				mHeldFill = 0;
+				throw Exception(std::make_error_code(std::errc::bad_message));
+			}
+			reserveTemp(mTempEnd - mTempCurr + mHeldFill);
+			if (mHeldFill)
+				std::memcpy(mTempCurr + (mTempEnd - mTempCurr), mHeldBeg.get(), mHeldFill);
+			mTempEnd += mHeldFill;
+			mHeldFill = 0;
 		}
-		Expect1(EVP_CIPHER_CTX_reset(mCtx.get()));
+		mFinalized = true;
 	}
 }
 
+void
+CipherDecrypt::reset(std::byte const* iv)
+{
+	if (!EVP_CIPHER_CTX_iv_length(mCtx.get())) // the key stream would be continued
+		throw Exception(std::make_error_code(std::errc::operation_not_supported));
+	rearm(nullptr, iv);
+}
+
+void
+CipherDecrypt::reset(Secret<> const& key, std::byte const* iv)
+{ rearm(key.get(), iv); }
+
+void
+CipherDecrypt::rearm(unsigned char const* key, std::byte const* iv)
+{
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()))
+		throw Exception(Stream::Input::Exception::Code::Uninitialized);
+
+	Expect1(EVP_DecryptInit_ex(mCtx.get(), nullptr, nullptr, key, reinterpret_cast<unsigned char const*>(iv)));
+	if (iv)
+		std::memcpy(mIv, iv, EVP_CIPHER_CTX_iv_length(mCtx.get()));
+	mTempEnd = mTempCurr = mTempBeg.get();
+	mHeldFill = 0;
+	mTagFill = 0;
+	mInputSize = std::numeric_limits<std::uint64_t>::max();
+	mFinalized = false;
+}
+
 void
 CipherDecrypt::finalizeDecryptionWhenNoData(bool on)
 { mFinalizeWhenNoData = on; }
 
+void
+CipherDecrypt::setReadAheadSize(std::size_t size)
+{
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()))
+		throw Exception(Stream::Input::Exception::Code::Uninitialized);
+
+	std::size_t blockSize = EVP_CIPHER_CTX_block_size(mCtx.get());
+	if (blockSize > 1)
+		size = (size + blockSize - 1) / blockSize * blockSize + blockSize;
+	reserveTemp(size);
+	mReadAheadSize = size;
+}
+
+void
+CipherDecrypt::setInputSize(std::uint64_t size) noexcept
+{ mInputSize = size; }
+
+bool
+CipherDecrypt::atEnd() const noexcept
+{ return mFinalized && mTempCurr == mTempEnd; }
+
+void
+CipherDecrypt::seek(std::uint64_t offset)
+{
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()) || mFinalized)
+		throw Exception(Stream::Input::Exception::Code::Uninitialized);
+	// OFB and the other feedback modes chain the keystream, they can not be positioned without decrypting
+	if (EVP_CIPHER_CTX_mode(mCtx.get()) != EVP_CIPH_CTR_MODE)
+		throw Exception(std::make_error_code(std::errc::operation_not_supported));
+
+	if (!Cipher::Seek(mCtx.get(), mIv, offset))
+		throw Exception(static_cast<Cipher::Exception::Code>(ERR_peek_last_error()));
+	mTempEnd = mTempCurr;
+}
+
 CipherEncrypt::CipherEncrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv)
 		: mCtx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free)
 {
@@ -133,6 +316,8 @@ swap(CipherEncrypt& a, CipherEncrypt& b) noexcept
 	swap(static_cast<Stream::TransformOutput&>(a), static_cast<Stream::TransformOutput&>(b));
 	std::swap(a.mCtx, b.mCtx);
 	std::swap(a.mExtSize, b.mExtSize);
+	std::swap(a.mTagSize, b.mTagSize);
+	std::swap(a.mFinalized, b.mFinalized);
 }
 
 CipherEncrypt&
@@ -146,6 +331,7 @@ void
 CipherEncrypt::init(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv)
 {
 	mExtSize = EVP_CIPHER_block_size(cipher) - 1;
+	mTagSize = Cipher::TagSize(cipher);
 	/*
 	if (EVP_CIPHER_mode(cipher) == EVP_CIPH_WRAP_MODE) {
 		EVP_CIPHER_CTX_set_flags(mCtx.get(), EVP_CIPHER_CTX_FLAG_WRAP_ALLOW);
@@ -156,10 +342,22 @@ CipherEncrypt::init(EVP_CIPHER const* cipher, Secret<> const& key, std::byte con
 	Expect1(EVP_EncryptInit_ex(mCtx.get(), cipher, nullptr, key.get(), reinterpret_cast<unsigned char const*>(iv)));
 }
 
+void
+CipherEncrypt::updateAAD(void const* aad, std::size_t size)
+{
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()) || mFinalized)
+		throw Exception(Stream::Output::Exception::Code::Uninitialized);
+	if (!mTagSize)
+		throw Exception(std::make_error_code(std::errc::operation_not_supported));
+
+	int outl;
+	Expect1(EVP_EncryptUpdate(mCtx.get(), nullptr, &outl, static_cast<unsigned char const*>(aad), static_cast<int>(size)));
+}
+
 std::size_t
 CipherEncrypt::writeBytes(std::byte const* src, std::size_t size)
 {
-	if (!EVP_CIPHER_CTX_cipher(mCtx.get()))
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()) || mFinalized)
 		throw Exception(Stream::Output::Exception::Code::Uninitialized);
 
 	provideSpace(size + mExtSize);
@@ -174,18 +372,45 @@ CipherEncrypt::writeBytes(std::byte const* src, std::size_t size)
 void
 CipherEncrypt::finalizeEncryption()
 {
-	if (EVP_CIPHER_CTX_cipher(mCtx.get())) {
+	if (EVP_CIPHER_CTX_cipher(mCtx.get()) && !mFinalized) {
 		if (EVP_CIPHER_CTX_block_size(mCtx.get()) > 1) {
 			provideSpace(EVP_CIPHER_CTX_block_size(mCtx.get()));
 			int outl;
 			Expect1(EVP_EncryptFinal_ex(mCtx.get(), reinterpret_cast<unsigned char*>(getSpace()), &outl));
 			advanceSpace(outl);
-			mExtSize = 0;
+		} else if (mTagSize) {
+			provideSpace(mTagSize);
+			int outl;
+			Expect1(EVP_EncryptFinal_ex(mCtx.get(), reinterpret_cast<unsigned char*>(getSpace()), &outl));
+			Expect1(EVP_CIPHER_CTX_ctrl(mCtx.get(), EVP_CTRL_AEAD_GET_TAG, mTagSize, getSpace() + outl));
+			advanceSpace(outl + mTagSize);
 		}
-		Expect1(EVP_CIPHER_CTX_reset(mCtx.get()));
+		mFinalized = true;
 	}
 }
 
+void
+CipherEncrypt::reset(std::byte const* iv)
+{
+	if (!EVP_CIPHER_CTX_iv_length(mCtx.get())) // the key stream would be continued
+		throw Exception(std::make_error_code(std::errc::operation_not_supported));
+	rearm(nullptr, iv);
+}
+
+void
+CipherEncrypt::reset(Secret<> const& key, std::byte const* iv)
+{ rearm(key.get(), iv); }
+
+void
+CipherEncrypt::rearm(unsigned char const* key, std::byte const* iv)
+{
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()))
+		throw Exception(Stream::Output::Exception::Code::Uninitialized);
+
+	Expect1(EVP_EncryptInit_ex(mCtx.get(), nullptr, nullptr, key, reinterpret_cast<unsigned char const*>(iv)));
+	mFinalized = false;
+}
+
 CipherEncrypt::~CipherEncrypt()
 {
 	try {
@@ -205,6 +430,38 @@ Cipher::Cipher(EVP_CIPHER const* decCipher, Secret<> const& decKey, std::byte co
 		, CipherEncrypt(encCipher, encKey, encIv)
 {}
 
+int
+Cipher::TagSize(EVP_CIPHER const* cipher) noexcept
+{
+	// only the AEAD modes that can be processed incrementally
+	if (EVP_CIPHER_mode(cipher) == EVP_CIPH_GCM_MODE)
+		return EVP_GCM_TLS_TAG_LEN;
+	if (EVP_CIPHER_nid(cipher) == NID_chacha20_poly1305)
+		return EVP_CHACHAPOLY_TLS_TAG_LEN;
+	return 0;
+}
+
+bool
+Cipher::Seek(EVP_CIPHER_CTX* ctx, unsigned char const* iv, std::uint64_t offset) noexcept
+{
+	// the counter block is as long as the iv and incremented as a big-endian integer
+	int ivLength = EVP_CIPHER_CTX_iv_length(ctx);
+	unsigned char counter[EVP_MAX_IV_LENGTH];
+	std::memcpy(counter, iv, ivLength);
+	std::uint64_t carry = offset / ivLength;
+	for (int i = ivLength - 1; carry && i >= 0; --i) {
+		carry += counter[i];
+		counter[i] = static_cast<unsigned char>(carry);
+		carry >>= 8;
+	}
+	if (1 != EVP_CipherInit_ex(ctx, nullptr, nullptr, nullptr, counter, -1))
+		return false;
+
+	unsigned char discard[EVP_MAX_IV_LENGTH] = {};
+	int outl;
+	return !(offset % ivLength) || 1 == EVP_CipherUpdate(ctx, discard, &outl, discard, static_cast<int>(offset % ivLength));
+}
+
 void
 swap(Cipher& a, Cipher& b) noexcept
 {
@@ -212,6 +469,198 @@ swap(Cipher& a, Cipher& b) noexcept
 	swap(static_cast<CipherEncrypt&>(a), static_cast<CipherEncrypt&>(b));
 }
 
+void
+Cipher::Encrypt(EVP_CIPHER const* cipher, std::span<Job> jobs)
+{
+	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx{EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free};
+	ExpectAllocated(ctx);
+	Expect1(EVP_EncryptInit_ex(ctx.get(), cipher, nullptr, nullptr, nullptr));
+
+	int tagSize = TagSize(cipher);
+	bool hasIv = EVP_CIPHER_iv_length(cipher);
+	Secret<> const* key = nullptr;
+	for (auto& job : jobs) {
+		// without an iv the key stream is restarted by the key only
+		Expect1(EVP_EncryptInit_ex(ctx.get(), nullptr, nullptr, job.key != key || !hasIv ? job.key->get() : nullptr,
+				reinterpret_cast<unsigned char const*>(job.iv)));
+		key = job.key;
+
+		auto* dest = reinterpret_cast<unsigned char*>(job.dest);
+		int outl, finl;
+		if (job.aadSize)
+			Expect1(EVP_EncryptUpdate(ctx.get(), nullptr, &outl,
+					reinterpret_cast<unsigned char const*>(job.aad), static_cast<int>(job.aadSize)));
+		Expect1(EVP_EncryptUpdate(ctx.get(), dest, &outl,
+				reinterpret_cast<unsigned char const*>(job.src), static_cast<int>(job.srcSize)));
+		Expect1(EVP_EncryptFinal_ex(ctx.get(), dest + outl, &finl));
+		if (tagSize)
+			Expect1(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_GET_TAG, tagSize, dest + outl + finl));
+		job.destSize = outl + finl + tagSize;
+		job.failed = false;
+	}
+}
+
+std::size_t
+Cipher::Decrypt(EVP_CIPHER const* cipher, std::span<Job> jobs)
+{
+	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx{EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free};
+	ExpectAllocated(ctx);
+	Expect1(EVP_DecryptInit_ex(ctx.get(), cipher, nullptr, nullptr, nullptr));
+
+	int tagSize = TagSize(cipher);
+	bool hasIv = EVP_CIPHER_iv_length(cipher);
+	Secret<> const* key = nullptr;
+	std::size_t failed = 0;
+	for (auto& job : jobs) {
+		job.destSize = 0;
+		if (job.srcSize < static_cast<std::size_t>(tagSize)) {
+			job.failed = true;
+			++failed;
+			continue;
+		}
+
+		Expect1(EVP_DecryptInit_ex(ctx.get(), nullptr, nullptr, job.key != key || !hasIv ? job.key->get() : nullptr,
+				reinterpret_cast<unsigned char const*>(job.iv)));
+		key = job.key;
+
+		auto const* src = reinterpret_cast<unsigned char const*>(job.src);
+		auto* dest = reinterpret_cast<unsigned char*>(job.dest);
+		std::size_t size = job.srcSize - tagSize;
+		int outl, finl;
+		if (tagSize)
+			Expect1(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_TAG, tagSize, const_cast<unsigned char*>(src + size)));
+		if (job.aadSize)
+			Expect1(EVP_DecryptUpdate(ctx.get(), nullptr, &outl,
+					reinterpret_cast<unsigned char const*>(job.aad), static_cast<int>(job.aadSize)));
+		Expect1(EVP_DecryptUpdate(ctx.get(), dest, &outl, src, static_cast<int>(size)));
+		job.failed = 1 != EVP_DecryptFinal_ex(ctx.get(), dest + outl, &finl);
+		if (job.failed) {
+			OPENSSL_cleanse(dest, outl); // plaintext of a forged message is never released
+			++failed;
+		} else
+			job.destSize = outl + finl;
+	}
+	return failed;
+}
+
+namespace {
+
+struct FileDescriptor {
+	int fd;
+
+	~FileDescriptor()
+	{ if (fd >= 0) ::close(fd); }
+};
+
+struct FileMapping {
+	void* addr = MAP_FAILED;
+	std::size_t size = 0;
+
+	~FileMapping()
+	{ if (addr != MAP_FAILED) ::munmap(addr, size); }
+
+	void
+	map(int fd, std::size_t length, int prot)
+	{
+		if (!length)
+			return;
+		addr = ::mmap(nullptr, length, prot, MAP_SHARED, fd, 0);
+		if (addr == MAP_FAILED)
+			throw Cipher::Exception(errno, std::system_category());
+		size = length;
+		::madvise(addr, size, MADV_SEQUENTIAL);
+	}
+};
+
+}//namespace
+
+std::uint64_t
+Cipher::CryptFile(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+		std::string const& src, std::string const& dest, bool encrypt)
+{
+	FileDescriptor in{::open(src.c_str(), O_RDONLY | O_CLOEXEC)};
+	struct stat inStat{};
+	if (in.fd < 0 || ::fstat(in.fd, &inStat))
+		throw Exception(errno, std::system_category());
+	std::size_t inSize = inStat.st_size;
+
+	int tagSize = TagSize(cipher);
+	if (!encrypt && inSize < static_cast<std::size_t>(tagSize))
+		throw Exception(std::make_error_code(std::errc::bad_message));
+	std::size_t dataSize = encrypt ? inSize : inSize - tagSize;
+	std::size_t outCapacity = encrypt
+			? inSize + (EVP_CIPHER_block_size(cipher) > 1 ? EVP_CIPHER_block_size(cipher) : 0) + tagSize
+			: dataSize;
+
+	// truncating src would destroy the input
+	struct stat outStat{};
+	if (!::stat(dest.c_str(), &outStat) && outStat.st_dev == inStat.st_dev && outStat.st_ino == inStat.st_ino)
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
+
+	FileDescriptor out{::open(dest.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)};
+	if (out.fd < 0)
+		throw Exception(errno, std::system_category());
+
+	std::size_t outSize = 0;
+	try {
+		if (::ftruncate(out.fd, static_cast<off_t>(outCapacity)))
+			throw Exception(errno, std::system_category());
+		{
+			FileMapping inMap, outMap;
+			inMap.map(in.fd, inSize, PROT_READ);
+			outMap.map(out.fd, outCapacity, PROT_READ | PROT_WRITE);
+			auto const* inData = static_cast<unsigned char const*>(inMap.addr);
+			auto* outData = static_cast<unsigned char*>(outMap.addr);
+
+			std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx{EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free};
+			ExpectAllocated(ctx);
+			Expect1(EVP_CipherInit_ex(ctx.get(), cipher, nullptr, key.get(), reinterpret_cast<unsigned char const*>(iv), encrypt));
+			if (!encrypt && tagSize)
+				Expect1(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_TAG, tagSize, const_cast<unsigned char*>(inData + dataSize)));
+
+			// EVP takes int sizes
+			constexpr std::size_t chunkSize = 1 << 30;
+			int outl;
+			for (std::size_t offset = 0; offset < dataSize; offset += chunkSize) {
+				Expect1(EVP_CipherUpdate(ctx.get(), outData + outSize, &outl, inData + offset,
+						static_cast<int>(std::min(chunkSize, dataSize - offset))));
+				outSize += outl;
+			}
+
+			unsigned char final[EVP_MAX_BLOCK_LENGTH];
+			if (1 != EVP_CipherFinal_ex(ctx.get(), final, &outl)) {
+				if (encrypt)
+					throw Exception(static_cast<Cipher::Exception::Code>(ERR_peek_last_error()));
+				throw Exception(std::make_error_code(std::errc::bad_message));
+			}
+			if (outl) // nothing is mapped for an empty output
+				std::memcpy(outData + outSize, final, outl);
+			outSize += outl;
+			if (encrypt && tagSize) {
+				Expect1(EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_GET_TAG, tagSize, outData + outSize));
+				outSize += tagSize;
+			}
+		}
+
+		if (::ftruncate(out.fd, static_cast<off_t>(outSize)))
+			throw Exception(errno, std::system_category());
+	} catch (...) {
+		::unlink(dest.c_str()); // never leave a partial or unverified output behind
+		throw;
+	}
+	return outSize;
+}
+
+std::uint64_t
+Cipher::EncryptFile(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+		std::string const& src, std::string const& dest)
+{ return CryptFile(cipher, key, iv, src, dest, true); }
+
+std::uint64_t
+Cipher::DecryptFile(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+		std::string const& src, std::string const& dest)
+{ return CryptFile(cipher, key, iv, src, dest, false); }
+
 std::error_code
 make_error_code(Cipher::Exception::Code e) noexcept
 {
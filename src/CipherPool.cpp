@@ -0,0 +1,117 @@
+#include "Security/CipherPool.hpp"
+#include <cstring>
+#include <openssl/crypto.h>
+#include <unistd.h>
+
+namespace Security {
+
+template <typename T>
+struct CipherPool::Lease<T>::Entry {
+	EVP_CIPHER const* cipher;
+	Secret<> key;
+	T stream;
+};//struct Security::CipherPool::Lease<T>::Entry
+
+template <typename T>
+CipherPool::Lease<T>::Lease(std::unique_ptr<Entry> entry) noexcept
+		: mEntry(std::move(entry))
+{}
+
+template <typename T>
+CipherPool::Lease<T>::Lease(Lease&& other) noexcept = default;
+
+template <typename T>
+CipherPool::Lease<T>&
+CipherPool::Lease<T>::operator=(Lease&& other) noexcept
+{
+	std::swap(mEntry, other.mEntry);
+	return *this;
+}
+
+template <typename T>
+CipherPool::Lease<T>::~Lease()
+{
+	if (!mEntry)
+		return;
+	if constexpr (std::is_same_v<T, CipherEncrypt>) {
+		try {
+			mEntry->stream.finalizeEncryption();
+			mEntry->stream.flush();
+		} catch (Stream::Output::Exception const& exc) {
+			::write(STDERR_FILENO, exc.what(), std::strlen(exc.what()));
+			return;
+		}
+	}
+	if (auto& released = Released<T>(); released.size() < Capacity)
+		released.push_back(std::move(mEntry));
+}
+
+template <typename T>
+T&
+CipherPool::Lease<T>::operator*() const noexcept
+{ return mEntry->stream; }
+
+template <typename T>
+T*
+CipherPool::Lease<T>::operator->() const noexcept
+{ return &mEntry->stream; }
+
+template class CipherPool::Lease<CipherDecrypt>;
+template class CipherPool::Lease<CipherEncrypt>;
+
+template <typename T>
+std::vector<std::unique_ptr<typename CipherPool::Lease<T>::Entry>>&
+CipherPool::Released()
+{
+	thread_local std::vector<std::unique_ptr<typename Lease<T>::Entry>> released = [] {
+		std::vector<std::unique_ptr<typename Lease<T>::Entry>> entries;
+		entries.reserve(Capacity);
+		return entries;
+	}();
+	return released;
+}
+
+template <typename T>
+CipherPool::Lease<T>
+CipherPool::Acquire(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv)
+{
+	auto& released = Released<T>();
+	for (auto it = released.rbegin(); it != released.rend(); ++it) {
+		auto& entry = **it;
+		if (entry.cipher == cipher && entry.key.size() == key.size() &&
+				!CRYPTO_memcmp(entry.key.get(), key.get(), key.size())) {
+			auto found = std::move(*it);
+			released.erase(std::next(it).base());
+			if (EVP_CIPHER_iv_length(cipher))
+				found->stream.reset(iv);
+			else // without an iv only the key restarts the key stream
+				found->stream.reset(key, iv);
+			return Lease<T>{std::move(found)};
+		}
+	}
+
+	for (auto it = released.rbegin(); it != released.rend(); ++it) {
+		if ((*it)->cipher == cipher && (*it)->key.size() == key.size()) {
+			auto found = std::move(*it);
+			released.erase(std::next(it).base());
+			std::memcpy(found->key.get(), key.get(), key.size());
+			found->stream.reset(key, iv);
+			return Lease<T>{std::move(found)};
+		}
+	}
+
+	std::unique_ptr<typename Lease<T>::Entry> entry{
+			new typename Lease<T>::Entry{cipher, Secret<>{key.size()}, T{cipher, key, iv}}};
+	std::memcpy(entry->key.get(), key.get(), key.size());
+	return Lease<T>{std::move(entry)};
+}
+
+CipherPool::Lease<CipherDecrypt>
+CipherPool::Decrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv)
+{ return Acquire<CipherDecrypt>(cipher, key, iv); }
+
+CipherPool::Lease<CipherEncrypt>
+CipherPool::Encrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv)
+{ return Acquire<CipherEncrypt>(cipher, key, iv); }
+
+}//namespace Security
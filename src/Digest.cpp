@@ -1,4 +1,5 @@
 #include "Security/Digest.hpp"
+#include <algorithm>
 #include <new>
 #include <openssl/err.h>
 
@@ -9,8 +10,10 @@ namespace Security {
 
 DigestInput::DigestInput(EVP_MD const* md, EVP_PKEY* key)
 		: mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mScratch(EVP_MD_CTX_new(), EVP_MD_CTX_free)
 {
 	ExpectAllocated(mCtx);
+	ExpectAllocated(mScratch);
 	if (key) {
 		Expect1(EVP_DigestSignInit(mCtx.get(), nullptr, md, nullptr, key));
 	} else {
@@ -34,6 +37,11 @@ swap(DigestInput& a, DigestInput& b) noexcept
 {
 	swap(static_cast<Stream::TransparentInput&>(a), static_cast<Stream::TransparentInput&>(b));
 	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mScratch, b.mScratch);
+	std::swap(a.mProcessed, b.mProcessed);
+	std::swap(a.mCheckpointInterval, b.mCheckpointInterval);
+	std::swap(a.mCheckpoint, b.mCheckpoint);
+	std::swap(a.mCheckpointDigest, b.mCheckpointDigest);
 }
 
 DigestInput&
@@ -47,13 +55,32 @@ std::size_t
 DigestInput::readBytes(std::byte* dest, std::size_t size)
 {
 	size = getSome(dest, size);
+	update(dest, size);
+	return size;
+}
 
-	if (EVP_MD_CTX_pkey_ctx(mCtx.get())) {
-		Expect1(EVP_DigestSignUpdate(mCtx.get(), dest, size));
-	} else {
-		Expect1(EVP_DigestUpdate(mCtx.get(), dest, size));
+void
+DigestInput::update(std::byte const* data, std::size_t size)
+{
+	while (size) {
+		std::size_t count = size;
+		if (mCheckpointInterval)
+			count = std::min<std::uint64_t>(count, mCheckpointInterval - mProcessed % mCheckpointInterval);
+
+		if (EVP_MD_CTX_pkey_ctx(mCtx.get())) {
+			Expect1(EVP_DigestSignUpdate(mCtx.get(), data, count));
+		} else {
+			Expect1(EVP_DigestUpdate(mCtx.get(), data, count));
+		}
+		mProcessed += count;
+		data += count;
+		size -= count;
+
+		if (mCheckpointInterval && mProcessed % mCheckpointInterval == 0) {
+			std::size_t digestSize = Digest::Value(mCtx.get(), mScratch.get(), mCheckpointDigest);
+			mCheckpoint(mProcessed, std::span<std::byte const>(mCheckpointDigest.data(), digestSize));
+		}
 	}
-	return size;
 }
 
 std::size_t
@@ -62,12 +89,31 @@ DigestInput::getInputDigestSize() const noexcept
 
 std::vector<std::byte>
 DigestInput::getInputDigest() const
-{ return Digest::Value(mCtx.get()); }
+{
+	std::vector<std::byte> val;
+	val.resize(getInputDigestSize());
+	val.resize(getInputDigest(val));
+	return val;
+}
+
+std::size_t
+DigestInput::getInputDigest(std::span<std::byte> dest) const
+{ return Digest::Value(mCtx.get(), dest); }
+
+void
+DigestInput::setCheckpoint(std::uint64_t interval, std::function<void(std::uint64_t, std::span<std::byte const>)> callback)
+{
+	mCheckpointDigest.resize(interval ? getInputDigestSize() : 0);
+	mCheckpointInterval = interval;
+	mCheckpoint = std::move(callback);
+}
 
 DigestOutput::DigestOutput(EVP_MD const* md, EVP_PKEY* key)
 		: mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mScratch(EVP_MD_CTX_new(), EVP_MD_CTX_free)
 {
 	ExpectAllocated(mCtx);
+	ExpectAllocated(mScratch);
 	if (key) {
 		Expect1(EVP_DigestSignInit(mCtx.get(), nullptr, md, nullptr, key));
 	} else {
@@ -91,6 +137,11 @@ swap(DigestOutput& a, DigestOutput& b) noexcept
 {
 	swap(static_cast<Stream::TransparentOutput&>(a), static_cast<Stream::TransparentOutput&>(b));
 	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mScratch, b.mScratch);
+	std::swap(a.mProcessed, b.mProcessed);
+	std::swap(a.mCheckpointInterval, b.mCheckpointInterval);
+	std::swap(a.mCheckpoint, b.mCheckpoint);
+	std::swap(a.mCheckpointDigest, b.mCheckpointDigest);
 }
 
 DigestOutput&
@@ -104,13 +155,32 @@ std::size_t
 DigestOutput::writeBytes(std::byte const* src, std::size_t size)
 {
 	size = putSome(src, size);
+	update(src, size);
+	return size;
+}
 
-	if (EVP_MD_CTX_pkey_ctx(mCtx.get())) {
-		Expect1(EVP_DigestSignUpdate(mCtx.get(), src, size));
-	} else {
-		Expect1(EVP_DigestUpdate(mCtx.get(), src, size));
+void
+DigestOutput::update(std::byte const* data, std::size_t size)
+{
+	while (size) {
+		std::size_t count = size;
+		if (mCheckpointInterval)
+			count = std::min<std::uint64_t>(count, mCheckpointInterval - mProcessed % mCheckpointInterval);
+
+		if (EVP_MD_CTX_pkey_ctx(mCtx.get())) {
+			Expect1(EVP_DigestSignUpdate(mCtx.get(), data, count));
+		} else {
+			Expect1(EVP_DigestUpdate(mCtx.get(), data, count));
+		}
+		mProcessed += count;
+		data += count;
+		size -= count;
+
+		if (mCheckpointInterval && mProcessed % mCheckpointInterval == 0) {
+			std::size_t digestSize = Digest::Value(mCtx.get(), mScratch.get(), mCheckpointDigest);
+			mCheckpoint(mProcessed, std::span<std::byte const>(mCheckpointDigest.data(), digestSize));
+		}
 	}
-	return size;
 }
 
 std::size_t
@@ -119,7 +189,24 @@ DigestOutput::getOutputDigestSize() const noexcept
 
 std::vector<std::byte>
 DigestOutput::getOutputDigest() const
-{ return Digest::Value(mCtx.get()); }
+{
+	std::vector<std::byte> val;
+	val.resize(getOutputDigestSize());
+	val.resize(getOutputDigest(val));
+	return val;
+}
+
+std::size_t
+DigestOutput::getOutputDigest(std::span<std::byte> dest) const
+{ return Digest::Value(mCtx.get(), dest); }
+
+void
+DigestOutput::setCheckpoint(std::uint64_t interval, std::function<void(std::uint64_t, std::span<std::byte const>)> callback)
+{
+	mCheckpointDigest.resize(interval ? getOutputDigestSize() : 0);
+	mCheckpointInterval = interval;
+	mCheckpoint = std::move(callback);
+}
 
 std::size_t
 Digest::Size(EVP_MD_CTX* ctx)
@@ -132,23 +219,38 @@ Digest::Size(EVP_MD_CTX* ctx)
 	return EVP_MD_size(EVP_MD_CTX_get0_md(ctx));
 }
 
-std::vector<std::byte>
-Digest::Value(EVP_MD_CTX* ctx)
+std::size_t
+Digest::Value(EVP_MD_CTX* ctx, EVP_MD_CTX* scratch, std::span<std::byte> dest)
 {
 	std::size_t size = Digest::Size(ctx);
-	std::vector<std::byte> val;
-	val.resize(size);
+	if (dest.size() < size)
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
 
 	if (EVP_MD_CTX_pkey_ctx(ctx)) {
-		Expect1(EVP_DigestSignFinal(ctx, reinterpret_cast<unsigned char*>(val.data()), &size));
+		Expect1(EVP_DigestSignFinal(ctx, reinterpret_cast<unsigned char*>(dest.data()), &size));
 	} else {
-		std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctxCopy{EVP_MD_CTX_new(), EVP_MD_CTX_free};
-		ExpectAllocated(ctxCopy);
-		Expect1(EVP_MD_CTX_copy(ctxCopy.get(), ctx));
-		Expect1(EVP_DigestFinal_ex(ctxCopy.get(), reinterpret_cast<unsigned char*>(val.data()), reinterpret_cast<unsigned int*>(&size)));
+		Expect1(EVP_MD_CTX_copy_ex(scratch, ctx)); // duplicates the provider context, which allocates
+		Expect1(EVP_DigestFinal_ex(scratch, reinterpret_cast<unsigned char*>(dest.data()), reinterpret_cast<unsigned int*>(&size)));
 	}
-	val.resize(size);
-	return val;
+	return size;
+}
+
+std::size_t
+Digest::Value(EVP_MD_CTX* ctx, std::span<std::byte> dest)
+{
+	// const getters may run concurrently, the scratch context of the stream is left to its checkpoints
+	thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> scratch{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+	ExpectAllocated(scratch);
+	return Value(ctx, scratch.get(), dest);
+}
+
+EVP_MD*
+Digest::Fetch(char const* name)
+{
+	EVP_MD* md = EVP_MD_fetch(nullptr, name, nullptr);
+	if (!md)
+		throw Exception(static_cast<Digest::Exception::Code>(ERR_peek_last_error()));
+	return md;
 }
 
 std::vector<std::byte>
@@ -181,10 +283,42 @@ Digest::Compute(void const* data, std::size_t count, EVP_MD const* md, Key const
 	return val;
 }
 
+void
+Digest::Compute(std::span<std::span<std::byte const> const> messages, EVP_MD const* md, std::byte* dest)
+{
+	std::unique_ptr<EVP_MD, decltype(&EVP_MD_free)> fetched{EVP_MD_fetch(nullptr, EVP_MD_get0_name(md), nullptr), EVP_MD_free};
+	if (!fetched)
+		throw Exception(static_cast<Digest::Exception::Code>(ERR_peek_last_error()));
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+	ExpectAllocated(ctx);
+
+	int size = EVP_MD_size(fetched.get());
+	for (auto const& message : messages) {
+		Expect1(EVP_DigestInit_ex(ctx.get(), fetched.get(), nullptr));
+		Expect1(EVP_DigestUpdate(ctx.get(), message.data(), message.size()));
+		Expect1(EVP_DigestFinal_ex(ctx.get(), reinterpret_cast<unsigned char*>(dest), nullptr));
+		dest += size;
+	}
+}
+
+void
+Digest::Compute(void const* data, std::size_t count, EVP_MD const* md, std::byte* dest)
+{
+	thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+	ExpectAllocated(ctx);
+	Expect1(EVP_DigestInit_ex(ctx.get(), md, nullptr));
+	Expect1(EVP_DigestUpdate(ctx.get(), data, count));
+	Expect1(EVP_DigestFinal_ex(ctx.get(), reinterpret_cast<unsigned char*>(dest), nullptr));
+}
+
 bool
 Digest::Matches(std::vector<std::byte> const& digest1, std::vector<std::byte> const& digest2) noexcept
 { return digest1.size() == digest2.size() && 0 == CRYPTO_memcmp(digest1.data(), digest2.data(), digest1.size()); }
 
+bool
+Digest::Matches(std::span<std::byte const> digest1, std::span<std::byte const> digest2) noexcept
+{ return digest1.size() == digest2.size() && 0 == CRYPTO_memcmp(digest1.data(), digest2.data(), digest1.size()); }
+
 Digest::Digest(EVP_MD const* md)
 		: Digest(md, md)
 {}
@@ -0,0 +1,257 @@
+#include "Security/DigestTree.hpp"
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <openssl/err.h>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+
+namespace Security {
+
+TreeHash::TreeHash(EVP_MD const* md, std::size_t leafSize, WorkerPool& pool)
+		: mMd(md)
+		, mPool(&pool)
+		, mLeafSize(leafSize ? leafSize : 1)
+		// enough full leaves to keep every worker and the calling thread busy
+		, mBufferSize(mLeafSize * (pool.getThreadCount() + 1))
+		, mBuffer(new std::byte[mBufferSize])
+{}
+
+bool
+TreeHash::hashLeaves(std::byte const* data, std::size_t count, decltype(mSubtrees)& subtrees, unsigned long& error) const
+{
+	std::size_t digestSize = getDigestSize();
+	std::vector<std::byte> hashes(count * digestSize);
+	std::atomic<bool> failed = false;
+	mPool->run(count, [&](std::size_t i) {
+		unsigned long leafError;
+		if (!DigestTree::Leaf(mMd, data + i * mLeafSize, mLeafSize, hashes.data() + i * digestSize, leafError)) {
+			// the error is queued on this thread, only the first failure reports it
+			if (!failed.exchange(true))
+				error = leafError;
+			ERR_clear_error();
+		}
+	});
+	if (failed)
+		return false;
+
+	for (std::size_t i = 0; i < count; ++i) {
+		subtrees.emplace_back(1, std::vector<std::byte>(hashes.begin() + static_cast<std::ptrdiff_t>(i * digestSize),
+				hashes.begin() + static_cast<std::ptrdiff_t>((i + 1) * digestSize)));
+		// subtrees of equal size are complete siblings
+		while (subtrees.size() > 1 && subtrees[subtrees.size() - 2].first == subtrees.back().first) {
+			auto& left = subtrees[subtrees.size() - 2];
+			if (!DigestTree::Node(mMd, left.second.data(), subtrees.back().second.data(), left.second.data(), error))
+				return false;
+			left.first *= 2;
+			subtrees.pop_back();
+		}
+	}
+	return true;
+}
+
+bool
+TreeHash::update(void const* data, std::size_t size, unsigned long& error)
+{
+	auto const* src = static_cast<std::byte const*>(data);
+	while (size) {
+		if (!mFill && size >= mBufferSize) { // hash in place
+			std::size_t count = size / mLeafSize;
+			if (!hashLeaves(src, count, mSubtrees, error))
+				return false;
+			src += count * mLeafSize;
+			size -= count * mLeafSize;
+			continue;
+		}
+		std::size_t copy = std::min(size, mBufferSize - mFill);
+		std::memcpy(mBuffer.get() + mFill, src, copy);
+		src += copy;
+		size -= copy;
+		if ((mFill += copy) == mBufferSize) {
+			if (!hashLeaves(mBuffer.get(), mBufferSize / mLeafSize, mSubtrees, error))
+				return false;
+			mFill = 0;
+		}
+	}
+	return true;
+}
+
+std::size_t
+TreeHash::getDigestSize() const noexcept
+{ return EVP_MD_size(mMd); }
+
+std::vector<std::byte>
+TreeHash::getDigest() const
+{
+	std::vector<std::byte> digest(getDigestSize());
+	auto subtrees = mSubtrees;
+	unsigned long error;
+	if (!hashLeaves(mBuffer.get(), mFill / mLeafSize, subtrees, error))
+		throw DigestTree::Exception(static_cast<DigestTree::Exception::Code>(error));
+	if (std::size_t rest = mFill % mLeafSize) {
+		subtrees.emplace_back(1, digest);
+		if (!DigestTree::Leaf(mMd, mBuffer.get() + mFill - rest, rest, subtrees.back().second.data(), error))
+			throw DigestTree::Exception(static_cast<DigestTree::Exception::Code>(error));
+	}
+
+	if (subtrees.empty()) {
+		if (1 != EVP_Digest(nullptr, 0, reinterpret_cast<unsigned char*>(digest.data()), nullptr, mMd, nullptr))
+			throw DigestTree::Exception(static_cast<DigestTree::Exception::Code>(ERR_peek_last_error()));
+		return digest;
+	}
+
+	digest = subtrees.back().second;
+	for (auto it = subtrees.rbegin() + 1; it != subtrees.rend(); ++it) {
+		if (!DigestTree::Node(mMd, it->second.data(), digest.data(), digest.data(), error))
+			throw DigestTree::Exception(static_cast<DigestTree::Exception::Code>(error));
+	}
+	return digest;
+}
+
+DigestTreeInput::DigestTreeInput(EVP_MD const* md, std::size_t leafSize, WorkerPool& pool)
+		: mHash(md, leafSize, pool)
+{}
+
+DigestTreeInput::DigestTreeInput(DigestTreeInput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(DigestTreeInput& a, DigestTreeInput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentInput&>(a), static_cast<Stream::TransparentInput&>(b));
+	std::swap(a.mHash, b.mHash);
+}
+
+DigestTreeInput&
+DigestTreeInput::operator=(DigestTreeInput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+DigestTreeInput::readBytes(std::byte* dest, std::size_t size)
+{
+	size = getSome(dest, size);
+	unsigned long error;
+	if (!mHash.update(dest, size, error))
+		throw Exception(static_cast<DigestTree::Exception::Code>(error));
+	return size;
+}
+
+std::size_t
+DigestTreeInput::getInputDigestSize() const noexcept
+{ return mHash.getDigestSize(); }
+
+std::vector<std::byte>
+DigestTreeInput::getInputDigest() const
+{ return mHash.getDigest(); }
+
+DigestTreeOutput::DigestTreeOutput(EVP_MD const* md, std::size_t leafSize, WorkerPool& pool)
+		: mHash(md, leafSize, pool)
+{}
+
+DigestTreeOutput::DigestTreeOutput(DigestTreeOutput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(DigestTreeOutput& a, DigestTreeOutput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentOutput&>(a), static_cast<Stream::TransparentOutput&>(b));
+	std::swap(a.mHash, b.mHash);
+}
+
+DigestTreeOutput&
+DigestTreeOutput::operator=(DigestTreeOutput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+DigestTreeOutput::writeBytes(std::byte const* src, std::size_t size)
+{
+	size = putSome(src, size);
+	unsigned long error;
+	if (!mHash.update(src, size, error))
+		throw Exception(static_cast<DigestTree::Exception::Code>(error));
+	return size;
+}
+
+std::size_t
+DigestTreeOutput::getOutputDigestSize() const noexcept
+{ return mHash.getDigestSize(); }
+
+std::vector<std::byte>
+DigestTreeOutput::getOutputDigest() const
+{ return mHash.getDigest(); }
+
+bool
+DigestTree::Leaf(EVP_MD const* md, void const* data, std::size_t size, std::byte* dest, unsigned long& error)
+{
+	thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+	ExpectAllocated(ctx);
+	unsigned char const prefix = 0x00;
+	if (1 == EVP_DigestInit_ex(ctx.get(), md, nullptr)
+			&& 1 == EVP_DigestUpdate(ctx.get(), &prefix, 1)
+			&& 1 == EVP_DigestUpdate(ctx.get(), data, size)
+			&& 1 == EVP_DigestFinal_ex(ctx.get(), reinterpret_cast<unsigned char*>(dest), nullptr))
+		return true;
+	error = ERR_peek_last_error();
+	return false;
+}
+
+bool
+DigestTree::Node(EVP_MD const* md, std::byte const* left, std::byte const* right, std::byte* dest, unsigned long& error)
+{
+	thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+	ExpectAllocated(ctx);
+	unsigned char const prefix = 0x01;
+	if (1 == EVP_DigestInit_ex(ctx.get(), md, nullptr)
+			&& 1 == EVP_DigestUpdate(ctx.get(), &prefix, 1)
+			&& 1 == EVP_DigestUpdate(ctx.get(), left, EVP_MD_size(md))
+			&& 1 == EVP_DigestUpdate(ctx.get(), right, EVP_MD_size(md))
+			&& 1 == EVP_DigestFinal_ex(ctx.get(), reinterpret_cast<unsigned char*>(dest), nullptr))
+		return true;
+	error = ERR_peek_last_error();
+	return false;
+}
+
+std::vector<std::byte>
+DigestTree::Compute(void const* data, std::size_t count, EVP_MD const* md, std::size_t leafSize, WorkerPool& pool)
+{
+	TreeHash hash{md, leafSize, pool};
+	unsigned long error;
+	if (!hash.update(data, count, error))
+		throw Exception(static_cast<Exception::Code>(error));
+	return hash.getDigest();
+}
+
+DigestTree::DigestTree(EVP_MD const* md, std::size_t leafSize, WorkerPool& pool)
+		: DigestTreeInput(md, leafSize, pool)
+		, DigestTreeOutput(md, leafSize, pool)
+{}
+
+void
+swap(DigestTree& a, DigestTree& b) noexcept
+{
+	swap(static_cast<DigestTreeInput&>(a), static_cast<DigestTreeInput&>(b));
+	swap(static_cast<DigestTreeOutput&>(a), static_cast<DigestTreeOutput&>(b));
+}
+
+std::error_code
+make_error_code(DigestTree::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::DigestTree"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
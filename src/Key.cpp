@@ -73,6 +73,16 @@ Key::Key(EC ecNid)
 	mVal.reset(k);
 }
 
+Key::Key(ED ed)
+{
+	std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> kctx{EVP_PKEY_CTX_new_id(static_cast<int>(ed), nullptr), EVP_PKEY_CTX_free};
+	ExpectInitialized(kctx);
+	Expect1(EVP_PKEY_keygen_init(kctx.get()));
+	EVP_PKEY* k = nullptr;
+	Expect1(EVP_PKEY_keygen(kctx.get(), &k));
+	mVal.reset(k);
+}
+
 Key::Key(RSA rsa)
 {
 	std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> kctx{EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr), EVP_PKEY_CTX_free};
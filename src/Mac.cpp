@@ -0,0 +1,116 @@
+#include "Security/Mac.hpp"
+#include <new>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+#define Expect1(x) if (1 != x) throw Exception(static_cast<Mac::Exception::Code>(ERR_peek_last_error()))
+
+namespace Security {
+
+Mac::Mac(char const* algorithm, char const* parameter, char const* name, Secret<> const& key)
+{
+	std::unique_ptr<EVP_MAC, decltype(&EVP_MAC_free)> mac{EVP_MAC_fetch(nullptr, algorithm, nullptr), EVP_MAC_free};
+	if (!mac)
+		throw Exception(static_cast<Mac::Exception::Code>(ERR_peek_last_error()));
+	mCtx.reset(EVP_MAC_CTX_new(mac.get()));
+	ExpectAllocated(mCtx);
+
+	OSSL_PARAM params[] = {
+			OSSL_PARAM_construct_utf8_string(parameter, const_cast<char*>(name), 0),
+			OSSL_PARAM_construct_end()};
+	Expect1(EVP_MAC_init(mCtx.get(), key.get(), key.size(), params));
+	mSize = EVP_MAC_CTX_get_mac_size(mCtx.get());
+}
+
+Mac::Mac(EVP_MD const* md, Secret<> const& key)
+		: Mac(OSSL_MAC_NAME_HMAC, OSSL_MAC_PARAM_DIGEST, EVP_MD_get0_name(md), key)
+{}
+
+Mac::Mac(EVP_CIPHER const* cipher, Secret<> const& key)
+		: Mac(OSSL_MAC_NAME_CMAC, OSSL_MAC_PARAM_CIPHER, EVP_CIPHER_get0_name(cipher), key)
+{}
+
+Mac::Mac(Mac const& other)
+		: mCtx(EVP_MAC_CTX_dup(other.mCtx.get()), EVP_MAC_CTX_free)
+		, mSize(other.mSize)
+{ ExpectAllocated(mCtx); }
+
+Mac::Mac(Mac&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(Mac& a, Mac& b) noexcept
+{
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mSize, b.mSize);
+}
+
+Mac&
+Mac::operator=(Mac&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+Mac::getSize() const noexcept
+{ return mSize; }
+
+void
+Mac::init()
+{ Expect1(EVP_MAC_init(mCtx.get(), nullptr, 0, nullptr)); } // keeps the key state
+
+void
+Mac::update(void const* data, std::size_t size)
+{ Expect1(EVP_MAC_update(mCtx.get(), static_cast<unsigned char const*>(data), size)); }
+
+std::size_t
+Mac::final(std::byte* dest)
+{
+	std::size_t size = 0;
+	Expect1(EVP_MAC_final(mCtx.get(), reinterpret_cast<unsigned char*>(dest), &size, mSize));
+	return size;
+}
+
+std::size_t
+Mac::compute(void const* data, std::size_t size, std::byte* dest)
+{
+	init();
+	update(data, size);
+	return final(dest);
+}
+
+std::vector<std::byte>
+Mac::compute(void const* data, std::size_t size)
+{
+	std::vector<std::byte> val(mSize);
+	val.resize(compute(data, size, val.data()));
+	return val;
+}
+
+bool
+Mac::verify(void const* data, std::size_t size, std::byte const* mac, std::size_t macSize)
+{
+	std::byte val[EVP_MAX_MD_SIZE];
+	std::size_t valSize = compute(data, size, val);
+	return valSize == macSize && 0 == CRYPTO_memcmp(val, mac, macSize);
+}
+
+std::error_code
+make_error_code(Mac::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::Mac"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
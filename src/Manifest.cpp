@@ -0,0 +1,369 @@
+#include "Security/Manifest.hpp"
+#include "Security/Digest.hpp"
+#include "Security/Signer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+#define Expect1(x) if (1 != x) throw Exception(static_cast<Manifest::Exception::Code>(ERR_peek_last_error()))
+
+namespace Security {
+
+namespace {
+
+template <typename T>
+void
+PutBE(std::byte*& p, T val) noexcept
+{
+	for (int i = sizeof(T) - 1; i >= 0; --i)
+		*p++ = static_cast<std::byte>(val >> (8 * i));
+}
+
+template <typename T>
+T
+GetBE(std::byte const*& p) noexcept
+{
+	T val = 0;
+	for (std::size_t i = 0; i < sizeof(T); ++i)
+		val = val << 8 | static_cast<T>(*p++);
+	return val;
+}
+
+std::uint64_t
+ChunkCount(std::uint64_t dataSize, std::uint32_t chunkSize) noexcept
+{ return chunkSize ? (dataSize + chunkSize - 1) / chunkSize : 0; }
+
+std::size_t
+ChunkSize(std::uint64_t index, std::uint64_t dataSize, std::uint32_t chunkSize) noexcept
+{ return std::min<std::uint64_t>(chunkSize, dataSize - index * chunkSize); }
+
+}//namespace
+
+Manifest::Manifest(EVP_MD const* md, std::uint32_t chunkSize, std::uint64_t dataSize, std::vector<std::byte> digests)
+		: mChunkSize(chunkSize)
+		, mDataSize(dataSize)
+		, mDigests(std::move(digests))
+{
+	if (!chunkSize || mDigests.size() != ChunkCount(dataSize, chunkSize) * EVP_MD_get_size(md))
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
+	// the name of a fetched digest is the same on both sides, legacy ones have their own
+	mMd.reset(EVP_MD_fetch(nullptr, EVP_MD_get0_name(md), nullptr));
+	if (!mMd)
+		throw Exception(static_cast<Exception::Code>(ERR_peek_last_error()));
+}
+
+Manifest::Manifest(Stream::Input& input, std::uint64_t maxChunkCount)
+{
+	std::byte buffer[4 + 8 + 1 + 255];
+	std::byte const* p = buffer;
+	input.read(buffer, 4 + 8 + 1);
+	mChunkSize = GetBE<std::uint32_t>(p);
+	mDataSize = GetBE<std::uint64_t>(p);
+	auto nameSize = GetBE<std::uint8_t>(p);
+	input.read(buffer + 4 + 8 + 1, nameSize);
+	std::string name(reinterpret_cast<char const*>(p), nameSize);
+
+	mMd.reset(EVP_MD_fetch(nullptr, name.c_str(), nullptr));
+	if (!mMd) {
+		ERR_clear_error();
+		throw Exception(std::make_error_code(std::errc::bad_message));
+	}
+	std::size_t digestSize = EVP_MD_get_size(mMd.get());
+	auto count = ChunkCount(mDataSize, mChunkSize);
+	// nothing is authenticated before the signature, the digests are allocated from the header
+	if (!mChunkSize || count > maxChunkCount || count > SIZE_MAX / digestSize)
+		throw Exception(std::make_error_code(std::errc::bad_message));
+	mDigests.resize(count * digestSize);
+	input.read(mDigests.data(), mDigests.size());
+
+	input.read(buffer, 4);
+	p = buffer;
+	auto signatureSize = GetBE<std::uint32_t>(p);
+	if (signatureSize > 64 * 1024)
+		throw Exception(std::make_error_code(std::errc::bad_message));
+	mSignature.resize(signatureSize);
+	input.read(mSignature.data(), mSignature.size());
+}
+
+Manifest
+Manifest::Compute(void const* data, std::size_t count, EVP_MD const* md, std::uint32_t chunkSize, WorkerPool& pool)
+{
+	if (!chunkSize)
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
+	std::size_t digestSize = EVP_MD_get_size(md);
+	std::vector<std::byte> digests(ChunkCount(count, chunkSize) * digestSize);
+	pool.run(ChunkCount(count, chunkSize), [&](std::size_t i) {
+		Digest::Compute(static_cast<std::byte const*>(data) + i * chunkSize, ChunkSize(i, count, chunkSize), md,
+				digests.data() + i * digestSize);
+	});
+	return {md, chunkSize, count, std::move(digests)};
+}
+
+Manifest::Manifest(Manifest&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(Manifest& a, Manifest& b) noexcept
+{
+	std::swap(a.mMd, b.mMd);
+	std::swap(a.mChunkSize, b.mChunkSize);
+	std::swap(a.mDataSize, b.mDataSize);
+	std::swap(a.mDigests, b.mDigests);
+	std::swap(a.mSignature, b.mSignature);
+}
+
+Manifest&
+Manifest::operator=(Manifest&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::uint32_t
+Manifest::getChunkSize() const noexcept
+{ return mChunkSize; }
+
+std::uint64_t
+Manifest::getDataSize() const noexcept
+{ return mDataSize; }
+
+std::uint64_t
+Manifest::getChunkCount() const noexcept
+{ return ChunkCount(mDataSize, mChunkSize); }
+
+std::vector<std::byte>
+Manifest::getBody() const
+{
+	std::string_view name(EVP_MD_get0_name(mMd.get()));
+	std::vector<std::byte> body(4 + 8 + 1 + name.size() + mDigests.size());
+	std::byte* p = body.data();
+	PutBE(p, mChunkSize);
+	PutBE(p, mDataSize);
+	PutBE(p, static_cast<std::uint8_t>(name.size()));
+	std::memcpy(p, name.data(), name.size());
+	std::memcpy(p + name.size(), mDigests.data(), mDigests.size());
+	return body;
+}
+
+void
+Manifest::sign(EVP_MD const* md, Key const& signKey)
+{
+	auto body = getBody();
+	mSignature = Signature::Sign(body.data(), body.size(), md, signKey);
+}
+
+bool
+Manifest::verifySignature(EVP_MD const* md, Key const& verifyKey) const
+{
+	auto body = getBody();
+	return Verifier(md, verifyKey).verify(body.data(), body.size(), mSignature);
+}
+
+bool
+Manifest::verifyChunk(std::uint64_t index, void const* data, std::size_t size) const
+{
+	if (index >= getChunkCount() || size != ChunkSize(index, mDataSize, mChunkSize))
+		return false;
+	std::size_t digestSize = EVP_MD_get_size(mMd.get());
+	std::byte digest[EVP_MAX_MD_SIZE];
+	Digest::Compute(data, size, mMd.get(), digest);
+	return !CRYPTO_memcmp(digest, mDigests.data() + index * digestSize, digestSize);
+}
+
+std::vector<bool>
+Manifest::verifyChunks(std::uint64_t first, std::span<std::span<std::byte const> const> chunks, WorkerPool& pool) const
+{
+	// a range writes a single word, threads never share one
+	std::vector<std::uint64_t> verified((chunks.size() + 63) / 64);
+	pool.run(verified.size(), [&](std::size_t range) {
+		std::uint64_t bits = 0;
+		for (std::size_t i = range * 64; i < std::min(chunks.size(), range * 64 + 64); ++i) {
+			if (verifyChunk(first + i, chunks[i].data(), chunks[i].size()))
+				bits |= std::uint64_t{1} << (i % 64);
+		}
+		verified[range] = bits;
+	});
+
+	std::vector<bool> val(chunks.size());
+	for (std::size_t i = 0; i < chunks.size(); ++i)
+		val[i] = verified[i / 64] >> (i % 64) & 1;
+	return val;
+}
+
+Stream::Output&
+operator<<(Stream::Output& output, Manifest const& manifest)
+{
+	auto body = manifest.getBody();
+	std::byte buffer[4];
+	std::byte* p = buffer;
+	PutBE(p, static_cast<std::uint32_t>(manifest.mSignature.size()));
+	output.write(body.data(), body.size());
+	output.write(buffer, 4);
+	return output.write(manifest.mSignature.data(), manifest.mSignature.size());
+}
+
+ManifestInput::ManifestInput(Manifest const& manifest)
+		: mManifest(&manifest)
+		, mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mChunk(new std::byte[std::min<std::uint64_t>(manifest.mChunkSize, manifest.mDataSize)])
+{
+	ExpectAllocated(mCtx);
+	mChunkEnd = mChunkCurr = mChunk.get();
+	Expect1(EVP_DigestInit_ex(mCtx.get(), manifest.mMd.get(), nullptr));
+}
+
+ManifestInput::ManifestInput(ManifestInput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(ManifestInput& a, ManifestInput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentInput&>(a), static_cast<Stream::TransparentInput&>(b));
+	std::swap(a.mManifest, b.mManifest);
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mChunk, b.mChunk);
+	std::swap(a.mChunkCurr, b.mChunkCurr);
+	std::swap(a.mChunkEnd, b.mChunkEnd);
+	std::swap(a.mIndex, b.mIndex);
+	std::swap(a.mFill, b.mFill);
+}
+
+ManifestInput&
+ManifestInput::operator=(ManifestInput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+ManifestInput::readBytes(std::byte* dest, std::size_t size)
+{
+	if (mChunkCurr != mChunkEnd) { // there is verified data
+		if (size > static_cast<std::size_t>(mChunkEnd - mChunkCurr))
+			size = mChunkEnd - mChunkCurr;
+		std::memcpy(dest, mChunkCurr, size);
+		mChunkCurr += size;
+		return size;
+	}
+
+	if (mIndex == mManifest->getChunkCount()) {
+		// the end of the source is expected, any more data is not covered by the manifest
+		if (getSome(dest, size))
+			throw Exception(std::make_error_code(std::errc::bad_message));
+		return 0;
+	}
+
+	// a chunk is kept until its digest is checked
+	std::size_t chunkSize = ChunkSize(mIndex, mManifest->mDataSize, mManifest->mChunkSize);
+	try {
+		mFill += static_cast<std::uint32_t>(getSome(mChunk.get() + mFill, chunkSize - mFill));
+	} catch (Stream::Input::Exception const& exc) {
+		if (exc.code() != std::make_error_code(std::errc::no_message_available))
+			throw;
+		throw Exception(std::make_error_code(std::errc::bad_message)); // truncated
+	}
+	if (mFill < chunkSize)
+		return 0;
+
+	std::size_t digestSize = EVP_MD_get_size(mManifest->mMd.get());
+	std::byte digest[EVP_MAX_MD_SIZE];
+	Expect1(EVP_DigestUpdate(mCtx.get(), mChunk.get(), chunkSize));
+	Expect1(EVP_DigestFinal_ex(mCtx.get(), reinterpret_cast<unsigned char*>(digest), nullptr));
+	Expect1(EVP_DigestInit_ex(mCtx.get(), nullptr, nullptr));
+	if (CRYPTO_memcmp(digest, mManifest->mDigests.data() + mIndex * digestSize, digestSize))
+		throw Exception(std::make_error_code(std::errc::bad_message));
+	mChunkEnd = (mChunkCurr = mChunk.get()) + chunkSize;
+	++mIndex;
+	mFill = 0;
+	return 0; // try again to read verified data
+}
+
+ManifestOutput::ManifestOutput(EVP_MD const* md, std::uint32_t chunkSize)
+		: mMd(md)
+		, mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mChunkSize(chunkSize)
+{
+	ExpectAllocated(mCtx);
+	if (!chunkSize)
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
+	Expect1(EVP_DigestInit_ex(mCtx.get(), md, nullptr));
+}
+
+ManifestOutput::ManifestOutput(ManifestOutput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(ManifestOutput& a, ManifestOutput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentOutput&>(a), static_cast<Stream::TransparentOutput&>(b));
+	std::swap(a.mMd, b.mMd);
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mChunkSize, b.mChunkSize);
+	std::swap(a.mFill, b.mFill);
+	std::swap(a.mDataSize, b.mDataSize);
+	std::swap(a.mDigests, b.mDigests);
+}
+
+ManifestOutput&
+ManifestOutput::operator=(ManifestOutput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+ManifestOutput::writeBytes(std::byte const* src, std::size_t size)
+{
+	size = putSome(src, size);
+	mDataSize += size;
+	for (std::size_t left = size; left;) {
+		std::size_t n = std::min<std::size_t>(left, mChunkSize - mFill);
+		Expect1(EVP_DigestUpdate(mCtx.get(), src, n));
+		src += n;
+		left -= n;
+		if ((mFill += n) == mChunkSize) {
+			auto offset = mDigests.size();
+			mDigests.resize(offset + EVP_MD_get_size(mMd));
+			Expect1(EVP_DigestFinal_ex(mCtx.get(), reinterpret_cast<unsigned char*>(mDigests.data() + offset), nullptr));
+			Expect1(EVP_DigestInit_ex(mCtx.get(), nullptr, nullptr));
+			mFill = 0;
+		}
+	}
+	return size;
+}
+
+Manifest
+ManifestOutput::getManifest() const
+{
+	auto digests = mDigests;
+	if (mFill) {
+		std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+		ExpectAllocated(ctx);
+		Expect1(EVP_MD_CTX_copy_ex(ctx.get(), mCtx.get()));
+		auto offset = digests.size();
+		digests.resize(offset + EVP_MD_get_size(mMd));
+		Expect1(EVP_DigestFinal_ex(ctx.get(), reinterpret_cast<unsigned char*>(digests.data() + offset), nullptr));
+	}
+	return {mMd, mChunkSize, mDataSize, std::move(digests)};
+}
+
+std::error_code
+make_error_code(Manifest::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::Manifest"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
@@ -0,0 +1,179 @@
+#include "Security/MultiDigest.hpp"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <openssl/err.h>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+#define Expect1(x) if (1 != x) throw MultiDigest::Exception(static_cast<MultiDigest::Exception::Code>(ERR_peek_last_error()))
+
+namespace Security {
+
+DigestSet::DigestSet(std::vector<EVP_MD const*> const& mds, WorkerPool* pool)
+		: mPool(pool)
+{
+	mCtxs.reserve(mds.size());
+	for (auto const* md : mds) {
+		auto& ctx = mCtxs.emplace_back(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+		ExpectAllocated(ctx);
+		Expect1(EVP_DigestInit_ex(ctx.get(), md, nullptr));
+	}
+}
+
+bool
+DigestSet::update(void const* data, std::size_t size, unsigned long& error)
+{
+	auto const* src = static_cast<unsigned char const*>(data);
+	if (mPool && mCtxs.size() > 1 && size >= ParallelSize) {
+		std::atomic<bool> failed = false;
+		mPool->run(mCtxs.size(), [&](std::size_t i) {
+			if (1 != EVP_DigestUpdate(mCtxs[i].get(), src, size)) {
+				// the error is queued on this thread, only the first failure reports it
+				if (!failed.exchange(true))
+					error = ERR_peek_last_error();
+				ERR_clear_error();
+			}
+		});
+		return !failed;
+	}
+
+	while (size) {
+		std::size_t tile = std::min(size, TileSize);
+		for (auto& ctx : mCtxs) {
+			if (1 != EVP_DigestUpdate(ctx.get(), src, tile)) {
+				error = ERR_peek_last_error();
+				return false;
+			}
+		}
+		src += tile;
+		size -= tile;
+	}
+	return true;
+}
+
+std::size_t
+DigestSet::getCount() const noexcept
+{ return mCtxs.size(); }
+
+std::size_t
+DigestSet::getDigestSize(std::size_t i) const noexcept
+{ return EVP_MD_size(EVP_MD_CTX_get0_md(mCtxs[i].get())); }
+
+std::vector<std::byte>
+DigestSet::getDigest(std::size_t i) const
+{
+	// const getters may run concurrently, every thread finalizes on its own copy
+	thread_local std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> scratch{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+	ExpectAllocated(scratch);
+	std::vector<std::byte> digest(getDigestSize(i));
+	Expect1(EVP_MD_CTX_copy_ex(scratch.get(), mCtxs[i].get()));
+	Expect1(EVP_DigestFinal_ex(scratch.get(), reinterpret_cast<unsigned char*>(digest.data()), nullptr));
+	return digest;
+}
+
+MultiDigestInput::MultiDigestInput(std::vector<EVP_MD const*> const& mds, WorkerPool* pool)
+		: mDigests(mds, pool)
+{}
+
+MultiDigestInput::MultiDigestInput(MultiDigestInput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(MultiDigestInput& a, MultiDigestInput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentInput&>(a), static_cast<Stream::TransparentInput&>(b));
+	std::swap(a.mDigests, b.mDigests);
+}
+
+MultiDigestInput&
+MultiDigestInput::operator=(MultiDigestInput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+MultiDigestInput::readBytes(std::byte* dest, std::size_t size)
+{
+	size = getSome(dest, size);
+	unsigned long error;
+	if (!mDigests.update(dest, size, error))
+		throw Exception(static_cast<MultiDigest::Exception::Code>(error));
+	return size;
+}
+
+std::size_t
+MultiDigestInput::getInputDigestSize(std::size_t i) const noexcept
+{ return mDigests.getDigestSize(i); }
+
+std::vector<std::byte>
+MultiDigestInput::getInputDigest(std::size_t i) const
+{ return mDigests.getDigest(i); }
+
+MultiDigestOutput::MultiDigestOutput(std::vector<EVP_MD const*> const& mds, WorkerPool* pool)
+		: mDigests(mds, pool)
+{}
+
+MultiDigestOutput::MultiDigestOutput(MultiDigestOutput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(MultiDigestOutput& a, MultiDigestOutput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentOutput&>(a), static_cast<Stream::TransparentOutput&>(b));
+	std::swap(a.mDigests, b.mDigests);
+}
+
+MultiDigestOutput&
+MultiDigestOutput::operator=(MultiDigestOutput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+MultiDigestOutput::writeBytes(std::byte const* src, std::size_t size)
+{
+	size = putSome(src, size);
+	unsigned long error;
+	if (!mDigests.update(src, size, error))
+		throw Exception(static_cast<MultiDigest::Exception::Code>(error));
+	return size;
+}
+
+std::size_t
+MultiDigestOutput::getOutputDigestSize(std::size_t i) const noexcept
+{ return mDigests.getDigestSize(i); }
+
+std::vector<std::byte>
+MultiDigestOutput::getOutputDigest(std::size_t i) const
+{ return mDigests.getDigest(i); }
+
+MultiDigest::MultiDigest(std::vector<EVP_MD const*> const& mds, WorkerPool* pool)
+		: MultiDigestInput(mds, pool)
+		, MultiDigestOutput(mds, pool)
+{}
+
+void
+swap(MultiDigest& a, MultiDigest& b) noexcept
+{
+	swap(static_cast<MultiDigestInput&>(a), static_cast<MultiDigestInput&>(b));
+	swap(static_cast<MultiDigestOutput&>(a), static_cast<MultiDigestOutput&>(b));
+}
+
+std::error_code
+make_error_code(MultiDigest::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::MultiDigest"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
@@ -0,0 +1,191 @@
+#include "Security/ParallelCipher.hpp"
+#include "Security/Cipher.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <openssl/err.h>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+#define Expect1(x) if (1 != x) throw Exception(static_cast<ParallelCipher::Exception::Code>(ERR_peek_last_error()))
+#define ExpectCounterMode(cipher, chunkSize) if (EVP_CIPHER_mode(cipher) != EVP_CIPH_CTR_MODE || !chunkSize || chunkSize > INT_MAX / 2) \
+		throw Exception(std::make_error_code(std::errc::invalid_argument))
+
+namespace Security {
+
+ParallelCipherDecrypt::ParallelCipherDecrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+		WorkerPool& pool, std::size_t chunkSize)
+		: mCtx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free)
+		, mPool(&pool)
+		, mChunkSize(chunkSize)
+{
+	ExpectAllocated(mCtx);
+	ExpectCounterMode(cipher, chunkSize);
+	std::memcpy(mIv, iv, EVP_CIPHER_iv_length(cipher));
+	Expect1(EVP_DecryptInit_ex(mCtx.get(), cipher, nullptr, key.get(), mIv));
+}
+
+ParallelCipherDecrypt::ParallelCipherDecrypt(ParallelCipherDecrypt&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(ParallelCipherDecrypt& a, ParallelCipherDecrypt& b) noexcept
+{
+	swap(static_cast<Stream::TransformInput&>(a), static_cast<Stream::TransformInput&>(b));
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mIv, b.mIv);
+	std::swap(a.mOffset, b.mOffset);
+	std::swap(a.mCtxOffset, b.mCtxOffset);
+	std::swap(a.mPool, b.mPool);
+	std::swap(a.mChunkSize, b.mChunkSize);
+}
+
+ParallelCipherDecrypt&
+ParallelCipherDecrypt::operator=(ParallelCipherDecrypt&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+ParallelCipherDecrypt::readBytes(std::byte* dest, std::size_t size)
+{
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()))
+		throw Exception(Stream::Input::Exception::Code::Uninitialized);
+
+	size = provideSomeData(size);
+	unsigned long error;
+	if (!ParallelCipher::Update(mCtx.get(), mIv, mCtxOffset, mOffset, *mPool, mChunkSize,
+			reinterpret_cast<unsigned char const*>(getData()), size, reinterpret_cast<unsigned char*>(dest), error))
+		throw Exception(static_cast<ParallelCipher::Exception::Code>(error));
+	advanceData(size);
+	mOffset += size;
+	return size;
+}
+
+void
+ParallelCipherDecrypt::seek(std::uint64_t offset) noexcept
+{ mOffset = offset; }
+
+ParallelCipherEncrypt::ParallelCipherEncrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+		WorkerPool& pool, std::size_t chunkSize)
+		: mCtx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free)
+		, mPool(&pool)
+		, mChunkSize(chunkSize)
+{
+	ExpectAllocated(mCtx);
+	ExpectCounterMode(cipher, chunkSize);
+	std::memcpy(mIv, iv, EVP_CIPHER_iv_length(cipher));
+	Expect1(EVP_EncryptInit_ex(mCtx.get(), cipher, nullptr, key.get(), mIv));
+}
+
+ParallelCipherEncrypt::ParallelCipherEncrypt(ParallelCipherEncrypt&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(ParallelCipherEncrypt& a, ParallelCipherEncrypt& b) noexcept
+{
+	swap(static_cast<Stream::TransformOutput&>(a), static_cast<Stream::TransformOutput&>(b));
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mIv, b.mIv);
+	std::swap(a.mOffset, b.mOffset);
+	std::swap(a.mCtxOffset, b.mCtxOffset);
+	std::swap(a.mPool, b.mPool);
+	std::swap(a.mChunkSize, b.mChunkSize);
+}
+
+ParallelCipherEncrypt&
+ParallelCipherEncrypt::operator=(ParallelCipherEncrypt&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+ParallelCipherEncrypt::writeBytes(std::byte const* src, std::size_t size)
+{
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()))
+		throw Exception(Stream::Output::Exception::Code::Uninitialized);
+
+	provideSpace(size);
+	unsigned long error;
+	if (!ParallelCipher::Update(mCtx.get(), mIv, mCtxOffset, mOffset, *mPool, mChunkSize,
+			reinterpret_cast<unsigned char const*>(src), size, reinterpret_cast<unsigned char*>(getSpace()), error))
+		throw Exception(static_cast<ParallelCipher::Exception::Code>(error));
+	advanceSpace(size);
+	mOffset += size;
+	return size;
+}
+
+bool
+ParallelCipher::Update(EVP_CIPHER_CTX* ctx, unsigned char const* iv, std::uint64_t& ctxOffset, std::uint64_t offset,
+		WorkerPool& pool, std::size_t chunkSize, unsigned char const* src, std::size_t size, unsigned char* dest,
+		unsigned long& error)
+{
+	int outl;
+	if (size < 2 * chunkSize) {
+		if ((ctxOffset != offset && !Cipher::Seek(ctx, iv, offset))
+				|| 1 != EVP_CipherUpdate(ctx, dest, &outl, src, static_cast<int>(size))) {
+			error = ERR_peek_last_error();
+			return false;
+		}
+		ctxOffset = offset + size;
+		return true;
+	}
+
+	// every chunk runs on a copy of ctx positioned at its own counter offset, ctx itself is left behind
+	std::atomic<bool> failed = false;
+	pool.run((size + chunkSize - 1) / chunkSize, [&](std::size_t i) {
+		thread_local std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> chunkCtx{EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free};
+		ExpectAllocated(chunkCtx);
+		std::size_t begin = i * chunkSize;
+		std::size_t length = std::min(chunkSize, size - begin);
+		int chunkOutl;
+		if (1 != EVP_CIPHER_CTX_copy(chunkCtx.get(), ctx)
+				|| !Cipher::Seek(chunkCtx.get(), iv, offset + begin)
+				|| 1 != EVP_CipherUpdate(chunkCtx.get(), dest + begin, &chunkOutl, src + begin, static_cast<int>(length))) {
+			// the error is queued on this thread, only the first failure reports it
+			if (!failed.exchange(true))
+				error = ERR_peek_last_error();
+			ERR_clear_error();
+		}
+	});
+	return !failed;
+}
+
+ParallelCipher::ParallelCipher(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* iv,
+		WorkerPool& pool, std::size_t chunkSize)
+		: ParallelCipher(cipher, key, iv, cipher, key, iv, pool, chunkSize)
+{}
+
+ParallelCipher::ParallelCipher(EVP_CIPHER const* decCipher, Secret<> const& decKey, std::byte const* decIv,
+		EVP_CIPHER const* encCipher, Secret<> const& encKey, std::byte const* encIv,
+		WorkerPool& pool, std::size_t chunkSize)
+		: ParallelCipherDecrypt(decCipher, decKey, decIv, pool, chunkSize)
+		, ParallelCipherEncrypt(encCipher, encKey, encIv, pool, chunkSize)
+{}
+
+void
+swap(ParallelCipher& a, ParallelCipher& b) noexcept
+{
+	swap(static_cast<ParallelCipherDecrypt&>(a), static_cast<ParallelCipherDecrypt&>(b));
+	swap(static_cast<ParallelCipherEncrypt&>(a), static_cast<ParallelCipherEncrypt&>(b));
+}
+
+std::error_code
+make_error_code(ParallelCipher::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::ParallelCipher"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
@@ -0,0 +1,276 @@
+// the low level digest functions are the only ones exposing the chaining values
+#define OPENSSL_SUPPRESS_DEPRECATED
+#include "Security/ResumableDigest.hpp"
+#include <cstring>
+#include <openssl/err.h>
+
+#define Expect1(x) if (1 != x) throw DigestState::Exception(static_cast<DigestState::Exception::Code>(ERR_peek_last_error()))
+
+namespace Security {
+
+namespace {
+
+template <typename T>
+void
+PutBE(std::byte*& p, T val) noexcept
+{
+	for (int i = sizeof(T) - 1; i >= 0; --i)
+		*p++ = static_cast<std::byte>(val >> (8 * i));
+}
+
+template <typename T>
+T
+GetBE(std::byte const*& p) noexcept
+{
+	T val = 0;
+	for (std::size_t i = 0; i < sizeof(T); ++i)
+		val = val << 8 | static_cast<T>(*p++);
+	return val;
+}
+
+std::size_t
+BlockSize(DigestState::Algorithm algorithm) noexcept
+{ return algorithm < DigestState::Algorithm::SHA384 ? SHA_CBLOCK : SHA512_CBLOCK; }
+
+}//namespace
+
+DigestState::DigestState(Algorithm algorithm)
+		: mAlgorithm(algorithm)
+{
+	switch (mAlgorithm) {
+		case Algorithm::SHA1: Expect1(SHA1_Init(&mCtx.sha1)); break;
+		case Algorithm::SHA224: Expect1(SHA224_Init(&mCtx.sha256)); break;
+		case Algorithm::SHA256: Expect1(SHA256_Init(&mCtx.sha256)); break;
+		case Algorithm::SHA384: Expect1(SHA384_Init(&mCtx.sha512)); break;
+		case Algorithm::SHA512: Expect1(SHA512_Init(&mCtx.sha512)); break;
+		default: throw Exception(std::make_error_code(std::errc::invalid_argument));
+	}
+}
+
+DigestState::DigestState(Stream::Input& input)
+		: DigestState([&input] {
+			std::uint8_t algorithm;
+			input.read(&algorithm, 1);
+			if (algorithm < 1 || algorithm > 5)
+				throw Exception(std::make_error_code(std::errc::bad_message));
+			return static_cast<Algorithm>(algorithm);
+		}())
+{
+	std::byte buffer[8 + 8 * 8 + SHA512_CBLOCK];
+	std::byte const* p = buffer;
+	input.read(buffer, 8);
+	mProcessed = GetBE<std::uint64_t>(p);
+	std::size_t num = mProcessed % BlockSize(mAlgorithm);
+
+	switch (mAlgorithm) {
+		case Algorithm::SHA1:
+			input.read(buffer + 8, 5 * 4 + num);
+			mCtx.sha1.h0 = GetBE<SHA_LONG>(p);
+			mCtx.sha1.h1 = GetBE<SHA_LONG>(p);
+			mCtx.sha1.h2 = GetBE<SHA_LONG>(p);
+			mCtx.sha1.h3 = GetBE<SHA_LONG>(p);
+			mCtx.sha1.h4 = GetBE<SHA_LONG>(p);
+			mCtx.sha1.Nl = static_cast<SHA_LONG>(mProcessed << 3);
+			mCtx.sha1.Nh = static_cast<SHA_LONG>(mProcessed >> 29);
+			std::memcpy(mCtx.sha1.data, p, num);
+			mCtx.sha1.num = num;
+			break;
+		case Algorithm::SHA224:
+		case Algorithm::SHA256:
+			input.read(buffer + 8, 8 * 4 + num);
+			for (auto& h : mCtx.sha256.h)
+				h = GetBE<SHA_LONG>(p);
+			mCtx.sha256.Nl = static_cast<SHA_LONG>(mProcessed << 3);
+			mCtx.sha256.Nh = static_cast<SHA_LONG>(mProcessed >> 29);
+			std::memcpy(mCtx.sha256.data, p, num);
+			mCtx.sha256.num = num;
+			break;
+		case Algorithm::SHA384:
+		case Algorithm::SHA512:
+			input.read(buffer + 8, 8 * 8 + num);
+			for (auto& h : mCtx.sha512.h)
+				h = GetBE<SHA_LONG64>(p);
+			mCtx.sha512.Nl = mProcessed << 3;
+			mCtx.sha512.Nh = mProcessed >> 61;
+			std::memcpy(mCtx.sha512.u.p, p, num);
+			mCtx.sha512.num = num;
+			break;
+	}
+}
+
+bool
+DigestState::update(void const* data, std::size_t size, unsigned long& error)
+{
+	int result = 0;
+	switch (mAlgorithm) {
+		case Algorithm::SHA1: result = SHA1_Update(&mCtx.sha1, data, size); break;
+		case Algorithm::SHA224: result = SHA224_Update(&mCtx.sha256, data, size); break;
+		case Algorithm::SHA256: result = SHA256_Update(&mCtx.sha256, data, size); break;
+		case Algorithm::SHA384: result = SHA384_Update(&mCtx.sha512, data, size); break;
+		case Algorithm::SHA512: result = SHA512_Update(&mCtx.sha512, data, size); break;
+	}
+	if (1 != result) {
+		error = ERR_peek_last_error();
+		return false;
+	}
+	mProcessed += size;
+	return true;
+}
+
+DigestState::Algorithm
+DigestState::getAlgorithm() const noexcept
+{ return mAlgorithm; }
+
+std::uint64_t
+DigestState::getProcessedSize() const noexcept
+{ return mProcessed; }
+
+std::size_t
+DigestState::getDigestSize() const noexcept
+{
+	switch (mAlgorithm) {
+		case Algorithm::SHA1: return SHA_DIGEST_LENGTH;
+		case Algorithm::SHA224: return SHA224_DIGEST_LENGTH;
+		case Algorithm::SHA256: return SHA256_DIGEST_LENGTH;
+		case Algorithm::SHA384: return SHA384_DIGEST_LENGTH;
+		default: return SHA512_DIGEST_LENGTH;
+	}
+}
+
+std::vector<std::byte>
+DigestState::getDigest() const
+{
+	std::vector<std::byte> digest(getDigestSize());
+	auto ctx = mCtx;
+	auto* md = reinterpret_cast<unsigned char*>(digest.data());
+	switch (mAlgorithm) {
+		case Algorithm::SHA1: Expect1(SHA1_Final(md, &ctx.sha1)); break;
+		case Algorithm::SHA224: Expect1(SHA224_Final(md, &ctx.sha256)); break;
+		case Algorithm::SHA256: Expect1(SHA256_Final(md, &ctx.sha256)); break;
+		case Algorithm::SHA384: Expect1(SHA384_Final(md, &ctx.sha512)); break;
+		case Algorithm::SHA512: Expect1(SHA512_Final(md, &ctx.sha512)); break;
+	}
+	OPENSSL_cleanse(&ctx, sizeof(ctx));
+	return digest;
+}
+
+Stream::Output&
+operator<<(Stream::Output& output, DigestState const& state)
+{
+	std::byte buffer[1 + 8 + 8 * 8 + SHA512_CBLOCK];
+	std::byte* p = buffer;
+	*p++ = static_cast<std::byte>(state.mAlgorithm);
+	PutBE(p, state.mProcessed);
+	std::size_t num = state.mProcessed % BlockSize(state.mAlgorithm);
+
+	switch (state.mAlgorithm) {
+		case DigestState::Algorithm::SHA1:
+			PutBE(p, state.mCtx.sha1.h0);
+			PutBE(p, state.mCtx.sha1.h1);
+			PutBE(p, state.mCtx.sha1.h2);
+			PutBE(p, state.mCtx.sha1.h3);
+			PutBE(p, state.mCtx.sha1.h4);
+			std::memcpy(p, state.mCtx.sha1.data, num);
+			break;
+		case DigestState::Algorithm::SHA224:
+		case DigestState::Algorithm::SHA256:
+			for (auto h : state.mCtx.sha256.h)
+				PutBE(p, h);
+			std::memcpy(p, state.mCtx.sha256.data, num);
+			break;
+		case DigestState::Algorithm::SHA384:
+		case DigestState::Algorithm::SHA512:
+			for (auto h : state.mCtx.sha512.h)
+				PutBE(p, h);
+			std::memcpy(p, state.mCtx.sha512.u.p, num);
+			break;
+	}
+	return output.write(buffer, p + num - buffer);
+}
+
+ResumableDigestInput::ResumableDigestInput(DigestState const& state)
+		: mState(state)
+{}
+
+ResumableDigestInput::ResumableDigestInput(ResumableDigestInput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(ResumableDigestInput& a, ResumableDigestInput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentInput&>(a), static_cast<Stream::TransparentInput&>(b));
+	std::swap(a.mState, b.mState);
+}
+
+ResumableDigestInput&
+ResumableDigestInput::operator=(ResumableDigestInput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+ResumableDigestInput::readBytes(std::byte* dest, std::size_t size)
+{
+	size = getSome(dest, size);
+	unsigned long error;
+	if (!mState.update(dest, size, error))
+		throw Exception(static_cast<DigestState::Exception::Code>(error));
+	return size;
+}
+
+DigestState const&
+ResumableDigestInput::getInputState() const noexcept
+{ return mState; }
+
+ResumableDigestOutput::ResumableDigestOutput(DigestState const& state)
+		: mState(state)
+{}
+
+ResumableDigestOutput::ResumableDigestOutput(ResumableDigestOutput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(ResumableDigestOutput& a, ResumableDigestOutput& b) noexcept
+{
+	swap(static_cast<Stream::TransparentOutput&>(a), static_cast<Stream::TransparentOutput&>(b));
+	std::swap(a.mState, b.mState);
+}
+
+ResumableDigestOutput&
+ResumableDigestOutput::operator=(ResumableDigestOutput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+ResumableDigestOutput::writeBytes(std::byte const* src, std::size_t size)
+{
+	size = putSome(src, size);
+	unsigned long error;
+	if (!mState.update(src, size, error))
+		throw Exception(static_cast<DigestState::Exception::Code>(error));
+	return size;
+}
+
+DigestState const&
+ResumableDigestOutput::getOutputState() const noexcept
+{ return mState; }
+
+std::error_code
+make_error_code(DigestState::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::DigestState"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
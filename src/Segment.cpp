@@ -0,0 +1,374 @@
+#include "Security/Segment.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/rand.h>
+#include <unistd.h>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+#define Expect1(x) if (1 != x) throw Exception(static_cast<Segment::Exception::Code>(ERR_peek_last_error()))
+#define TAG_SIZE EVP_GCM_TLS_TAG_LEN
+
+namespace Security {
+
+SegmentDecrypt::SegmentDecrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::uint32_t maxSegmentSize)
+		: mCtx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free)
+		, mMaxSegmentSize(maxSegmentSize)
+		, mHeaderSize(Segment::HeaderSize(cipher))
+{
+	ExpectAllocated(mCtx);
+	if (!mHeaderSize)
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
+	mHeader.reset(new unsigned char[mHeaderSize]);
+	Expect1(EVP_DecryptInit_ex(mCtx.get(), cipher, nullptr, key.get(), nullptr));
+}
+
+SegmentDecrypt::SegmentDecrypt(SegmentDecrypt&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(SegmentDecrypt& a, SegmentDecrypt& b) noexcept
+{
+	swap(static_cast<Stream::TransformInput&>(a), static_cast<Stream::TransformInput&>(b));
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mHeader, b.mHeader);
+	std::swap(a.mSegment, b.mSegment);
+	std::swap(a.mPlainCurr, b.mPlainCurr);
+	std::swap(a.mPlainEnd, b.mPlainEnd);
+	std::swap(a.mSegmentSize, b.mSegmentSize);
+	std::swap(a.mMaxSegmentSize, b.mMaxSegmentSize);
+	std::swap(a.mSegmentFill, b.mSegmentFill);
+	std::swap(a.mIndex, b.mIndex);
+	std::swap(a.mHeaderSize, b.mHeaderSize);
+	std::swap(a.mHeaderFill, b.mHeaderFill);
+	std::swap(a.mLast, b.mLast);
+}
+
+SegmentDecrypt&
+SegmentDecrypt::operator=(SegmentDecrypt&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+void
+SegmentDecrypt::readHeader()
+{
+	while (mHeaderFill < mHeaderSize) {
+		std::size_t size = provideSomeData(mHeaderSize - mHeaderFill);
+		std::memcpy(mHeader.get() + mHeaderFill, getData(), size);
+		mHeaderFill += static_cast<int>(size);
+		advanceData(size);
+	}
+
+	// the header is authenticated with the first segment, its size is bounded before the segment is buffered
+	mSegmentSize = Segment::SegmentSize(mHeader.get());
+	if (!mSegmentSize || mSegmentSize > mMaxSegmentSize)
+		throw Exception(std::make_error_code(std::errc::bad_message));
+	mSegment.reset(new unsigned char[mSegmentSize + TAG_SIZE]);
+	mPlainEnd = mPlainCurr = mSegment.get();
+}
+
+std::size_t
+SegmentDecrypt::readBytes(std::byte* dest, std::size_t size)
+{
+	if (mPlainCurr != mPlainEnd) { // there is verified plaintext
+		if (size > static_cast<std::size_t>(mPlainEnd - mPlainCurr))
+			size = mPlainEnd - mPlainCurr;
+		std::memcpy(dest, mPlainCurr, size);
+		mPlainCurr += size;
+		return size;
+	}
+
+	if (mLast)
+		throw Exception(std::make_error_code(std::errc::no_message_available));
+
+	if (mHeaderFill < mHeaderSize)
+		readHeader();
+
+	while (mSegmentFill < mSegmentSize + TAG_SIZE) {
+		try {
+			size = provideSomeData(mSegmentSize + TAG_SIZE - mSegmentFill);
+		} catch (Stream::Input::Exception const& exc) {
+			if (exc.code() != std::make_error_code(std::errc::no_message_available))
+				throw;
+			mLast = true;
+			break;
+		}
+		std::memcpy(mSegment.get() + mSegmentFill, getData(), size);
+		mSegmentFill += static_cast<std::uint32_t>(size);
+		advanceData(size);
+	}
+
+	if (mSegmentFill < TAG_SIZE // truncated
+			|| !Segment::Open(mCtx.get(), mHeader.get(), mHeaderSize, mIndex, mLast, mSegment.get(), mSegmentFill, mSegment.get()))
+		throw Exception(std::make_error_code(std::errc::bad_message));
+
+	mPlainEnd = (mPlainCurr = mSegment.get()) + mSegmentFill - TAG_SIZE;
+	mSegmentFill = 0;
+	++mIndex;
+	return 0; // try again to read from mSegment
+}
+
+std::uint64_t
+SegmentDecrypt::seek(std::uint32_t index)
+{
+	if (mHeaderFill < mHeaderSize)
+		readHeader();
+
+	mPlainEnd = mPlainCurr = mSegment.get();
+	mSegmentFill = 0;
+	mIndex = index;
+	mLast = false;
+	return mHeaderSize + static_cast<std::uint64_t>(index) * (mSegmentSize + TAG_SIZE);
+}
+
+SegmentEncrypt::SegmentEncrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::uint32_t segmentSize)
+		: mCtx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free)
+		, mSegmentSize(segmentSize)
+		, mHeaderSize(Segment::HeaderSize(cipher))
+{
+	ExpectAllocated(mCtx);
+	if (!mHeaderSize || !segmentSize || segmentSize > INT32_MAX - TAG_SIZE)
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
+
+	mHeader.reset(new unsigned char[mHeaderSize]);
+	mHeader[0] = segmentSize >> 24;
+	mHeader[1] = segmentSize >> 16;
+	mHeader[2] = segmentSize >> 8;
+	mHeader[3] = segmentSize;
+	Expect1(RAND_bytes(mHeader.get() + 4, mHeaderSize - 4));
+
+	mSegment.reset(new unsigned char[segmentSize]);
+	Expect1(EVP_EncryptInit_ex(mCtx.get(), cipher, nullptr, key.get(), nullptr));
+}
+
+SegmentEncrypt::SegmentEncrypt(SegmentEncrypt&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(SegmentEncrypt& a, SegmentEncrypt& b) noexcept
+{
+	swap(static_cast<Stream::TransformOutput&>(a), static_cast<Stream::TransformOutput&>(b));
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mHeader, b.mHeader);
+	std::swap(a.mSegment, b.mSegment);
+	std::swap(a.mSegmentSize, b.mSegmentSize);
+	std::swap(a.mSegmentFill, b.mSegmentFill);
+	std::swap(a.mIndex, b.mIndex);
+	std::swap(a.mHeaderSize, b.mHeaderSize);
+	std::swap(a.mHeaderWritten, b.mHeaderWritten);
+}
+
+SegmentEncrypt&
+SegmentEncrypt::operator=(SegmentEncrypt&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+void
+SegmentEncrypt::seal(unsigned char const* src, std::uint32_t size, bool last)
+{
+	if (!last && mIndex == UINT32_MAX)
+		throw Exception(std::make_error_code(std::errc::value_too_large));
+
+	if (!mHeaderWritten) {
+		provideSpace(mHeaderSize);
+		std::memcpy(getSpace(), mHeader.get(), mHeaderSize);
+		advanceSpace(mHeaderSize);
+		mHeaderWritten = true;
+	}
+
+	unsigned char nonce[EVP_MAX_IV_LENGTH];
+	Segment::Nonce(nonce, mHeader.get(), mHeaderSize, mIndex, last);
+
+	provideSpace(size + TAG_SIZE);
+	auto* out = reinterpret_cast<unsigned char*>(getSpace());
+	int outl;
+	Expect1(EVP_EncryptInit_ex(mCtx.get(), nullptr, nullptr, nullptr, nonce));
+	Expect1(EVP_EncryptUpdate(mCtx.get(), nullptr, &outl, mHeader.get(), mHeaderSize));
+	Expect1(EVP_EncryptUpdate(mCtx.get(), out, &outl, src, static_cast<int>(size)));
+	Expect1(EVP_EncryptFinal_ex(mCtx.get(), out + size, &outl));
+	Expect1(EVP_CIPHER_CTX_ctrl(mCtx.get(), EVP_CTRL_AEAD_GET_TAG, TAG_SIZE, out + size));
+	advanceSpace(size + TAG_SIZE);
+	++mIndex;
+}
+
+std::size_t
+SegmentEncrypt::writeBytes(std::byte const* src, std::size_t size)
+{
+	if (!EVP_CIPHER_CTX_cipher(mCtx.get()))
+		throw Exception(Stream::Output::Exception::Code::Uninitialized);
+
+	if (!mSegmentFill && size >= mSegmentSize) { // seal directly from src
+		seal(reinterpret_cast<unsigned char const*>(src), mSegmentSize, false);
+		return mSegmentSize;
+	}
+
+	if (size > mSegmentSize - mSegmentFill)
+		size = mSegmentSize - mSegmentFill;
+	std::memcpy(mSegment.get() + mSegmentFill, src, size);
+	mSegmentFill += static_cast<std::uint32_t>(size);
+	if (mSegmentFill == mSegmentSize) {
+		seal(mSegment.get(), mSegmentSize, false);
+		mSegmentFill = 0;
+	}
+	return size;
+}
+
+void
+SegmentEncrypt::finalizeEncryption()
+{
+	if (EVP_CIPHER_CTX_cipher(mCtx.get())) {
+		seal(mSegment.get(), mSegmentFill, true);
+		mSegmentFill = 0;
+		Expect1(EVP_CIPHER_CTX_reset(mCtx.get()));
+	}
+}
+
+SegmentEncrypt::~SegmentEncrypt()
+{
+	try {
+		finalizeEncryption();
+	} catch (Stream::Output::Exception const& exc) {
+		::write(STDERR_FILENO, exc.what(), std::strlen(exc.what()));
+	}
+}
+
+int
+Segment::HeaderSize(EVP_CIPHER const* cipher)
+{
+	if (!(EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER) || EVP_CIPHER_iv_length(cipher) < 8)
+		return 0;
+	return 4 + EVP_CIPHER_iv_length(cipher) - 5;
+}
+
+std::uint32_t
+Segment::SegmentSize(unsigned char const* header) noexcept
+{
+	std::uint32_t segmentSize = static_cast<std::uint32_t>(header[0]) << 24 | static_cast<std::uint32_t>(header[1]) << 16
+			| static_cast<std::uint32_t>(header[2]) << 8 | static_cast<std::uint32_t>(header[3]);
+	return segmentSize > INT32_MAX - TAG_SIZE ? 0 : segmentSize;
+}
+
+void
+Segment::Nonce(unsigned char* nonce, unsigned char const* header, int headerSize, std::uint32_t index, bool last) noexcept
+{
+	std::memcpy(nonce, header + 4, headerSize - 4);
+	nonce += headerSize - 4;
+	nonce[0] = index >> 24;
+	nonce[1] = index >> 16;
+	nonce[2] = index >> 8;
+	nonce[3] = index;
+	nonce[4] = last;
+}
+
+bool
+Segment::Open(EVP_CIPHER_CTX* ctx, unsigned char const* header, int headerSize, std::uint32_t index, bool last,
+		unsigned char const* src, std::uint32_t size, unsigned char* dest) noexcept
+{
+	unsigned char nonce[EVP_MAX_IV_LENGTH];
+	Segment::Nonce(nonce, header, headerSize, index, last);
+
+	int outl;
+	size -= TAG_SIZE;
+	if (1 == EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, nonce)
+			&& 1 == EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, TAG_SIZE, const_cast<unsigned char*>(src + size))
+			&& 1 == EVP_DecryptUpdate(ctx, nullptr, &outl, header, headerSize)
+			&& 1 == EVP_DecryptUpdate(ctx, dest, &outl, src, static_cast<int>(size))
+			&& 1 == EVP_DecryptFinal_ex(ctx, dest + size, &outl))
+		return true;
+	OPENSSL_cleanse(dest, size); // plaintext of a forged segment is never released
+	return false;
+}
+
+std::size_t
+Segment::PlainSize(EVP_CIPHER const* cipher, std::byte const* src, std::size_t size)
+{
+	int headerSize = Segment::HeaderSize(cipher);
+	if (!headerSize)
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
+	if (size < static_cast<std::size_t>(headerSize) + TAG_SIZE)
+		throw Exception(std::make_error_code(std::errc::bad_message));
+
+	std::uint64_t segmentSize = Segment::SegmentSize(reinterpret_cast<unsigned char const*>(src));
+	if (!segmentSize)
+		throw Exception(std::make_error_code(std::errc::bad_message));
+
+	size -= headerSize;
+	std::uint64_t fullCount = size / (segmentSize + TAG_SIZE);
+	std::uint64_t lastSize = size % (segmentSize + TAG_SIZE);
+	if (lastSize < TAG_SIZE || fullCount >= UINT32_MAX)
+		throw Exception(std::make_error_code(std::errc::bad_message));
+	return fullCount * segmentSize + lastSize - TAG_SIZE;
+}
+
+std::size_t
+Segment::Decrypt(EVP_CIPHER const* cipher, Secret<> const& key, std::byte const* src, std::size_t size, std::byte* dest,
+		WorkerPool& pool)
+{
+	std::size_t plainSize = Segment::PlainSize(cipher, src, size);
+	int headerSize = Segment::HeaderSize(cipher);
+	auto const* header = reinterpret_cast<unsigned char const*>(src);
+	std::uint32_t segmentSize = Segment::SegmentSize(header);
+	auto segmentCount = static_cast<std::uint32_t>((size - headerSize) / (segmentSize + TAG_SIZE) + 1);
+
+	auto decrypt = [&](std::uint32_t first, std::uint32_t end) {
+		std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx{EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free};
+		ExpectAllocated(ctx);
+		Expect1(EVP_DecryptInit_ex(ctx.get(), cipher, nullptr, key.get(), nullptr));
+		for (std::uint32_t i = first; i < end; ++i) {
+			bool last = i + 1 == segmentCount;
+			auto const* in = header + headerSize + static_cast<std::size_t>(i) * (segmentSize + TAG_SIZE);
+			auto* out = reinterpret_cast<unsigned char*>(dest) + static_cast<std::size_t>(i) * segmentSize;
+			auto inSize = last ? static_cast<std::uint32_t>(plainSize - static_cast<std::size_t>(i) * segmentSize) + TAG_SIZE : segmentSize + TAG_SIZE;
+			if (!Segment::Open(ctx.get(), header, headerSize, i, last, in, inSize, out))
+				throw Exception(std::make_error_code(std::errc::bad_message));
+		}
+	};
+
+	// a range of segments shares a context
+	std::size_t rangeCount = std::min<std::size_t>(segmentCount, pool.getThreadCount() + 1);
+	pool.run(rangeCount, [&](std::size_t range) {
+		decrypt(static_cast<std::uint32_t>(segmentCount * range / rangeCount),
+				static_cast<std::uint32_t>(segmentCount * (range + 1) / rangeCount));
+	});
+	return plainSize;
+}
+
+Segment::Segment(EVP_CIPHER const* cipher, Secret<> const& key, std::uint32_t segmentSize)
+		: Segment(cipher, key, cipher, key, segmentSize)
+{}
+
+Segment::Segment(EVP_CIPHER const* decCipher, Secret<> const& decKey,
+		EVP_CIPHER const* encCipher, Secret<> const& encKey, std::uint32_t segmentSize)
+		: SegmentDecrypt(decCipher, decKey, std::max(segmentSize, SegmentDecrypt::MaxSegmentSize))
+		, SegmentEncrypt(encCipher, encKey, segmentSize)
+{}
+
+void
+swap(Segment& a, Segment& b) noexcept
+{
+	swap(static_cast<SegmentDecrypt&>(a), static_cast<SegmentDecrypt&>(b));
+	swap(static_cast<SegmentEncrypt&>(a), static_cast<SegmentEncrypt&>(b));
+}
+
+std::error_code
+make_error_code(Segment::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::Segment"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
@@ -1,6 +1,10 @@
 #include "Security/Signature.hpp"
+#include <algorithm>
+#include <cstring>
 #include <new>
+#include <string_view>
 #include <openssl/err.h>
+#include <openssl/objects.h>
 
 #define ExpectAllocated(x) if (!x) throw std::bad_alloc()
 #define Expect1(x) if (1 != x) throw Exception(static_cast<Signature::Exception::Code>(ERR_peek_last_error()))
@@ -11,7 +15,13 @@ SignatureInput::SignatureInput(EVP_MD const* md, Key const& verifyKey)
 		: mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
 {
 	ExpectAllocated(mCtx);
-	Expect1(EVP_DigestVerifyInit(mCtx.get(), nullptr, md, nullptr, static_cast<EVP_PKEY*>(verifyKey)));
+	if (Signature::IsOneShot(static_cast<EVP_PKEY*>(verifyKey))) {
+		Expect1(EVP_PKEY_up_ref(static_cast<EVP_PKEY*>(verifyKey)));
+		mPrehashKey.reset(static_cast<EVP_PKEY*>(verifyKey));
+		Expect1(EVP_DigestInit_ex(mCtx.get(), md ? md : EVP_sha512(), nullptr));
+	} else {
+		Expect1(EVP_DigestVerifyInit(mCtx.get(), nullptr, md, nullptr, static_cast<EVP_PKEY*>(verifyKey)));
+	}
 }
 
 SignatureInput::SignatureInput(SignatureInput&& other) noexcept
@@ -22,6 +32,7 @@ swap(SignatureInput& a, SignatureInput& b) noexcept
 {
 	swap(static_cast<Stream::TransparentInput&>(a), static_cast<Stream::TransparentInput&>(b));
 	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mPrehashKey, b.mPrehashKey);
 }
 
 SignatureInput&
@@ -36,19 +47,35 @@ SignatureInput::readBytes(std::byte* dest, std::size_t size)
 {
 	size = getSome(dest, size);
 
-	Expect1(EVP_DigestVerifyUpdate(mCtx.get(), dest, size));
+	if (mPrehashKey) {
+		Expect1(EVP_DigestUpdate(mCtx.get(), dest, size));
+	} else {
+		Expect1(EVP_DigestVerifyUpdate(mCtx.get(), dest, size));
+	}
 	return size;
 }
 
 bool
 SignatureInput::verifySignature(std::vector<std::byte> const& signature) const
-{ return Signature::Verify(mCtx.get(), signature); }
+{
+	if (mPrehashKey) {
+		auto message = Signature::Prehash(mCtx.get());
+		return Signature::Verify(message.data(), message.size(), nullptr, mPrehashKey.get(), signature);
+	}
+	return Signature::Verify(mCtx.get(), signature);
+}
 
 SignatureOutput::SignatureOutput(EVP_MD const* md, Key const& signKey)
 		: mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
 {
 	ExpectAllocated(mCtx);
-	Expect1(EVP_DigestSignInit(mCtx.get(), nullptr, md, nullptr, static_cast<EVP_PKEY*>(signKey)));
+	if (Signature::IsOneShot(static_cast<EVP_PKEY*>(signKey))) {
+		Expect1(EVP_PKEY_up_ref(static_cast<EVP_PKEY*>(signKey)));
+		mPrehashKey.reset(static_cast<EVP_PKEY*>(signKey));
+		Expect1(EVP_DigestInit_ex(mCtx.get(), md ? md : EVP_sha512(), nullptr));
+	} else {
+		Expect1(EVP_DigestSignInit(mCtx.get(), nullptr, md, nullptr, static_cast<EVP_PKEY*>(signKey)));
+	}
 }
 
 SignatureOutput::SignatureOutput(SignatureOutput&& other) noexcept
@@ -59,6 +86,7 @@ swap(SignatureOutput& a, SignatureOutput& b) noexcept
 {
 	swap(static_cast<Stream::TransparentOutput&>(a), static_cast<Stream::TransparentOutput&>(b));
 	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mPrehashKey, b.mPrehashKey);
 }
 
 SignatureOutput&
@@ -73,17 +101,27 @@ SignatureOutput::writeBytes(std::byte const* src, std::size_t size)
 {
 	size = putSome(src, size);
 
-	Expect1(EVP_DigestSignUpdate(mCtx.get(), src, size));
+	if (mPrehashKey) {
+		Expect1(EVP_DigestUpdate(mCtx.get(), src, size));
+	} else {
+		Expect1(EVP_DigestSignUpdate(mCtx.get(), src, size));
+	}
 	return size;
 }
 
 std::size_t
 SignatureOutput::getSignatureSize() const
-{ return Signature::Size(mCtx.get()); }
+{ return mPrehashKey ? EVP_PKEY_get_size(mPrehashKey.get()) : Signature::Size(mCtx.get()); }
 
 std::vector<std::byte>
 SignatureOutput::getSignature() const
-{ return Signature::Sign(mCtx.get()); }
+{
+	if (mPrehashKey) {
+		auto message = Signature::Prehash(mCtx.get());
+		return Signature::Sign(message.data(), message.size(), nullptr, mPrehashKey.get());
+	}
+	return Signature::Sign(mCtx.get());
+}
 
 std::size_t
 Signature::Size(EVP_MD_CTX* ctx)
@@ -107,32 +145,136 @@ Signature::Sign(EVP_MD_CTX* ctx)
 
 std::vector<std::byte>
 Signature::Sign(void const* data, std::size_t count, EVP_MD const* md, Key const& signKey)
+{ return Signature::Sign(data, count, md, static_cast<EVP_PKEY*>(signKey)); }
+
+std::vector<std::byte>
+Signature::Sign(void const* data, std::size_t count, EVP_MD const* md, EVP_PKEY* signKey)
 {
 	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx{EVP_MD_CTX_new(), EVP_MD_CTX_free};
 	ExpectAllocated(ctx);
-	Expect1(EVP_DigestSignInit(ctx.get(), nullptr, md, nullptr, static_cast<EVP_PKEY*>(signKey)));
-	Expect1(EVP_DigestSignUpdate(ctx.get(), data, count));
-	return Signature::Sign(ctx.get());
+	Expect1(EVP_DigestSignInit(ctx.get(), nullptr, md, nullptr, signKey));
+	// one shot, also supported by EdDSA keys
+	std::size_t size = 0;
+	Expect1(EVP_DigestSign(ctx.get(), nullptr, &size, static_cast<unsigned char const*>(data), count));
+	std::vector<std::byte> val;
+	val.resize(size);
+	Expect1(EVP_DigestSign(ctx.get(), reinterpret_cast<unsigned char*>(val.data()), &size, static_cast<unsigned char const*>(data), count));
+	val.resize(size);
+	return val;
 }
 
 bool
 Signature::Verify(EVP_MD_CTX* ctx, std::vector<std::byte> const& signature)
 {
-	auto result = EVP_DigestVerifyFinal(ctx, reinterpret_cast<unsigned char const*>(signature.data()), signature.size());
-	if (result < 0)
-		throw Exception(static_cast<Signature::Exception::Code>(ERR_peek_last_error()));
-	return result;
+	unsigned long callerError = ERR_peek_last_error();
+	ERR_set_mark();
+	return Verified(EVP_DigestVerifyFinal(ctx, reinterpret_cast<unsigned char const*>(signature.data()), signature.size()),
+			callerError);
 }
 
 bool
 Signature::Verify(void const* data, std::size_t count, EVP_MD const* md, Key const& verifyKey, std::vector<std::byte> const& signature)
+{ return Signature::Verify(data, count, md, static_cast<EVP_PKEY*>(verifyKey), signature); }
+
+bool
+Signature::Verify(void const* data, std::size_t count, EVP_MD const* md, EVP_PKEY* verifyKey, std::vector<std::byte> const& signature)
 {
 	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx{EVP_MD_CTX_new(), EVP_MD_CTX_free};
 	ExpectAllocated(ctx);
-	EVP_MD_CTX_set_flags(ctx.get(), EVP_MD_CTX_FLAG_ONESHOT);
-	Expect1(EVP_DigestVerifyInit(ctx.get(), nullptr, md, nullptr, static_cast<EVP_PKEY*>(verifyKey)));
-	Expect1(EVP_DigestVerifyUpdate(ctx.get(), data, count));
-	return Signature::Verify(ctx.get(), signature);
+	Expect1(EVP_DigestVerifyInit(ctx.get(), nullptr, md, nullptr, verifyKey));
+	// one shot, also supported by EdDSA keys
+	unsigned long callerError = ERR_peek_last_error();
+	ERR_set_mark();
+	return Verified(EVP_DigestVerify(ctx.get(), reinterpret_cast<unsigned char const*>(signature.data()), signature.size(),
+			static_cast<unsigned char const*>(data), count), callerError);
+}
+
+bool
+Signature::Verified(int result, unsigned long callerError)
+{
+	unsigned long error = ERR_peek_last_error();
+	ERR_pop_to_mark();
+	if (result < 0 && error != callerError)
+		throw Exception(static_cast<Signature::Exception::Code>(error));
+	return 1 == result;
+}
+
+bool
+Signature::IsOneShot(EVP_PKEY* key) noexcept
+{ return EVP_PKEY_get_id(key) == EVP_PKEY_ED25519 || EVP_PKEY_get_id(key) == EVP_PKEY_ED448; }
+
+std::vector<std::byte>
+Signature::Prehash(EVP_MD_CTX* ctx)
+{
+	std::string_view const prefix = "Security::Signature prehash";
+	// implementation names differ, "SHA512" for EVP_sha512() and "SHA2-512" once fetched, the OID does not
+	auto const* md = EVP_MD_CTX_get0_md(ctx);
+	std::string_view const name = EVP_MD_get_type(md) != NID_undef ? OBJ_nid2sn(EVP_MD_get_type(md)) : EVP_MD_get0_name(md);
+	std::vector<std::byte> message(prefix.size() + name.size() + 1 + EVP_MD_CTX_get_size(ctx));
+	std::memcpy(message.data(), prefix.data(), prefix.size());
+	std::memcpy(message.data() + prefix.size(), name.data(), name.size());
+
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctxCopy{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+	ExpectAllocated(ctxCopy);
+	Expect1(EVP_MD_CTX_copy_ex(ctxCopy.get(), ctx));
+	Expect1(EVP_DigestFinal_ex(ctxCopy.get(), reinterpret_cast<unsigned char*>(message.data() + prefix.size() + name.size() + 1), nullptr));
+	return message;
+}
+
+bool
+Signature::Verify(Job const& job, EVP_MD const* md)
+{
+	// copying an initialized context costs a fraction of initializing one, as Verifier does
+	thread_local struct {
+		std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+		struct {
+			std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+			EVP_PKEY* key = nullptr;
+			EVP_MD const* md = nullptr;
+		} templates[4];
+		std::size_t next = 0;
+	} cache;
+	ExpectAllocated(cache.ctx);
+
+	auto* key = static_cast<EVP_PKEY*>(*job.verifyKey);
+	auto* tmpl = std::find_if(std::begin(cache.templates), std::end(cache.templates),
+			[&](auto const& t) { return t.key == key && t.md == md; });
+	if (tmpl == std::end(cache.templates)) {
+		// a template holds a reference to its key, another key cannot reuse the address while it is cached
+		tmpl = &cache.templates[cache.next++ % std::size(cache.templates)];
+		tmpl->key = nullptr;
+		ExpectAllocated(tmpl->ctx);
+		Expect1(EVP_MD_CTX_reset(tmpl->ctx.get()));
+		Expect1(EVP_DigestVerifyInit(tmpl->ctx.get(), nullptr, md, nullptr, key));
+		tmpl->key = key;
+		tmpl->md = md;
+	}
+	Expect1(EVP_MD_CTX_copy_ex(cache.ctx.get(), tmpl->ctx.get()));
+	// malformed signatures leave errors, the ones of the caller are kept
+	ERR_set_mark();
+	auto result = EVP_DigestVerify(cache.ctx.get(), reinterpret_cast<unsigned char const*>(job.signature), job.signatureSize,
+			static_cast<unsigned char const*>(job.data), job.count);
+	ERR_pop_to_mark();
+	return 1 == result;
+}
+
+std::vector<bool>
+Signature::Verify(std::span<Job const> jobs, EVP_MD const* md, WorkerPool& pool)
+{
+	// a range writes a single word, threads never share one
+	std::vector<std::uint64_t> verified((jobs.size() + 63) / 64);
+	pool.run(verified.size(), [&](std::size_t range) {
+		std::uint64_t bits = 0;
+		for (std::size_t i = range * 64; i < std::min(jobs.size(), range * 64 + 64); ++i)
+			if (Verify(jobs[i], md))
+				bits |= std::uint64_t{1} << (i % 64);
+		verified[range] = bits;
+	});
+
+	std::vector<bool> val(jobs.size());
+	for (std::size_t i = 0; i < jobs.size(); ++i)
+		val[i] = verified[i / 64] >> (i % 64) & 1;
+	return val;
 }
 
 Signature::Signature(EVP_MD const* md, Key const& key)
@@ -0,0 +1,118 @@
+#include "Security/Signer.hpp"
+#include <new>
+#include <openssl/err.h>
+
+#define ExpectAllocated(x) if (!x) throw std::bad_alloc()
+#define Expect1(x) if (1 != x) throw Signature::Exception(static_cast<Signature::Exception::Code>(ERR_peek_last_error()))
+
+namespace Security {
+
+Signer::Signer(EVP_MD const* md, Key const& signKey)
+		: mTemplate(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mSize(EVP_PKEY_get_size(static_cast<EVP_PKEY*>(signKey)))
+{
+	ExpectAllocated(mTemplate);
+	ExpectAllocated(mCtx);
+	Expect1(EVP_DigestSignInit(mTemplate.get(), nullptr, md, nullptr, static_cast<EVP_PKEY*>(signKey)));
+}
+
+Signer::Signer(Signer const& other)
+		: mTemplate(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mSize(other.mSize)
+{
+	ExpectAllocated(mTemplate);
+	ExpectAllocated(mCtx);
+	Expect1(EVP_MD_CTX_copy_ex(mTemplate.get(), other.mTemplate.get()));
+}
+
+Signer::Signer(Signer&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(Signer& a, Signer& b) noexcept
+{
+	std::swap(a.mTemplate, b.mTemplate);
+	std::swap(a.mCtx, b.mCtx);
+	std::swap(a.mSize, b.mSize);
+}
+
+Signer&
+Signer::operator=(Signer&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+std::size_t
+Signer::getSignatureSize() const noexcept
+{ return mSize; }
+
+std::size_t
+Signer::sign(void const* data, std::size_t count, std::byte* dest)
+{
+	std::size_t size = mSize;
+	Expect1(EVP_MD_CTX_copy_ex(mCtx.get(), mTemplate.get()));
+	Expect1(EVP_DigestSign(mCtx.get(), reinterpret_cast<unsigned char*>(dest), &size, static_cast<unsigned char const*>(data), count));
+	return size;
+}
+
+std::vector<std::byte>
+Signer::sign(void const* data, std::size_t count)
+{
+	std::vector<std::byte> val(mSize);
+	val.resize(sign(data, count, val.data()));
+	return val;
+}
+
+Verifier::Verifier(EVP_MD const* md, Key const& verifyKey)
+		: mTemplate(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+{
+	ExpectAllocated(mTemplate);
+	ExpectAllocated(mCtx);
+	Expect1(EVP_DigestVerifyInit(mTemplate.get(), nullptr, md, nullptr, static_cast<EVP_PKEY*>(verifyKey)));
+}
+
+Verifier::Verifier(Verifier const& other)
+		: mTemplate(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+		, mCtx(EVP_MD_CTX_new(), EVP_MD_CTX_free)
+{
+	ExpectAllocated(mTemplate);
+	ExpectAllocated(mCtx);
+	Expect1(EVP_MD_CTX_copy_ex(mTemplate.get(), other.mTemplate.get()));
+}
+
+Verifier::Verifier(Verifier&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(Verifier& a, Verifier& b) noexcept
+{
+	std::swap(a.mTemplate, b.mTemplate);
+	std::swap(a.mCtx, b.mCtx);
+}
+
+Verifier&
+Verifier::operator=(Verifier&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+bool
+Verifier::verify(void const* data, std::size_t count, std::byte const* signature, std::size_t signatureSize)
+{
+	Expect1(EVP_MD_CTX_copy_ex(mCtx.get(), mTemplate.get()));
+	unsigned long callerError = ERR_peek_last_error();
+	ERR_set_mark();
+	return Signature::Verified(EVP_DigestVerify(mCtx.get(), reinterpret_cast<unsigned char const*>(signature), signatureSize,
+			static_cast<unsigned char const*>(data), count), callerError);
+}
+
+bool
+Verifier::verify(void const* data, std::size_t count, std::vector<std::byte> const& signature)
+{ return verify(data, count, signature.data(), signature.size()); }
+
+}//namespace Security
@@ -0,0 +1,111 @@
+#include "Security/VerifyQueue.hpp"
+#include <algorithm>
+
+namespace Security {
+
+VerifyQueue::VerifyQueue(EVP_MD const* md, WorkerPool& pool, std::size_t capacity)
+		: mMd(md)
+		, mPool(pool)
+		, mCapacity(std::max<std::size_t>(capacity, 1))
+{}
+
+VerifyQueue::~VerifyQueue()
+{ wait(); }
+
+void
+VerifyQueue::enqueue(Entry entry)
+{
+	std::unique_lock lock{mMutex};
+	mSpace.wait(lock, [this] { return mEntries.size() < mCapacity; });
+	entry.submitted = Clock::now();
+	mEntries.push_back(std::move(entry));
+	++mStatistics.depth;
+	if (mWorkers < mPool.getThreadCount()) {
+		++mWorkers;
+		lock.unlock();
+		mPool.submit([this] { work(); });
+	}
+}
+
+void
+VerifyQueue::work()
+{
+	std::unique_lock lock{mMutex};
+	while (!mEntries.empty()) {
+		Entry entry = std::move(mEntries.front());
+		mEntries.pop_front();
+		--mStatistics.depth;
+		++mStatistics.active;
+		lock.unlock();
+		mSpace.notify_one();
+
+		auto started = Clock::now();
+		bool verified = false;
+		std::exception_ptr error;
+		try {
+			verified = Signature::Verify(entry.job, mMd);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		if (entry.callback) {
+			try {
+				entry.callback(verified);
+			} catch (...) {}
+		} else if (error) {
+			entry.promise.set_exception(error);
+		} else {
+			entry.promise.set_value(verified);
+		}
+		auto completed = Clock::now();
+
+		lock.lock();
+		--mStatistics.active;
+		++mStatistics.completed;
+		mStatistics.totalWait += started - entry.submitted;
+		mStatistics.maxWait = std::max(mStatistics.maxWait, started - entry.submitted);
+		mStatistics.totalLatency += completed - entry.submitted;
+		mStatistics.maxLatency = std::max(mStatistics.maxLatency, completed - entry.submitted);
+	}
+	if (!--mWorkers)
+		mIdle.notify_all();
+}
+
+std::future<bool>
+VerifyQueue::submit(Signature::Job const& job)
+{
+	Entry entry{job, {}, {}, {}};
+	auto future = entry.promise.get_future();
+	enqueue(std::move(entry));
+	return future;
+}
+
+void
+VerifyQueue::submit(Signature::Job const& job, Callback callback)
+{ enqueue({job, {}, std::move(callback), {}}); }
+
+void
+VerifyQueue::wait()
+{
+	std::unique_lock lock{mMutex};
+	mIdle.wait(lock, [this] { return !mWorkers; });
+}
+
+std::size_t
+VerifyQueue::getDepth() const
+{
+	std::lock_guard lock{mMutex};
+	return mEntries.size();
+}
+
+unsigned
+VerifyQueue::getThreadCount() const noexcept
+{ return mPool.getThreadCount(); }
+
+VerifyQueue::Statistics
+VerifyQueue::getStatistics() const
+{
+	std::lock_guard lock{mMutex};
+	return mStatistics;
+}
+
+}//namespace Security
@@ -0,0 +1,325 @@
+#include "Security/Verity.hpp"
+#include "Security/DigestTree.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace Security {
+
+namespace {
+
+constexpr std::size_t HeaderSize = 4 + 4 + 8;
+
+struct FileDescriptor {
+	int fd;
+
+	~FileDescriptor()
+	{ if (fd >= 0) ::close(fd); }
+};
+
+template <typename E>
+void
+ReadAll(int fd, void* dest, std::size_t size, std::uint64_t offset)
+{
+	auto* p = static_cast<std::byte*>(dest);
+	while (size) {
+		auto n = ::pread(fd, p, size, static_cast<off_t>(offset));
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			throw E(errno, std::system_category());
+		}
+		if (n == 0)
+			throw E(std::make_error_code(std::errc::bad_message));
+		p += n;
+		size -= n;
+		offset += n;
+	}
+}
+
+void
+WriteAll(int fd, void const* src, std::size_t size)
+{
+	auto const* p = static_cast<std::byte const*>(src);
+	while (size) {
+		auto n = ::write(fd, p, size);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			throw Verity::Exception(errno, std::system_category());
+		}
+		p += n;
+		size -= n;
+	}
+}
+
+std::uint64_t
+FileSize(int fd)
+{
+	struct stat st{};
+	if (::fstat(fd, &st))
+		throw Verity::Exception(errno, std::system_category());
+	return st.st_size;
+}
+
+std::vector<std::uint64_t>
+LevelSizes(std::uint64_t blockCount)
+{
+	std::vector<std::uint64_t> sizes;
+	if (blockCount) {
+		sizes.push_back(blockCount);
+		while (sizes.back() > 1)
+			sizes.push_back((sizes.back() + 1) / 2);
+	}
+	return sizes;
+}
+
+std::uint64_t
+NodeKey(std::size_t level, std::uint64_t index) noexcept
+{ return static_cast<std::uint64_t>(level) << 56 | index; }
+
+std::vector<std::byte>
+EmptyDigest(EVP_MD const* md)
+{
+	std::vector<std::byte> digest(EVP_MD_size(md));
+	if (1 != EVP_Digest(nullptr, 0, reinterpret_cast<unsigned char*>(digest.data()), nullptr, md, nullptr))
+		throw Verity::Exception(static_cast<Verity::Exception::Code>(ERR_peek_last_error()));
+	return digest;
+}
+
+}//namespace
+
+VerityInput::VerityInput(EVP_MD const* md, std::string const& data, std::string const& tree,
+		std::vector<std::byte> const& root, std::size_t cacheSize)
+		: mMd(md)
+		, mDigestSize(EVP_MD_size(md))
+		, mCacheSize(std::max<std::size_t>(cacheSize, 1))
+{
+	FileDescriptor dataFile{::open(data.c_str(), O_RDONLY | O_CLOEXEC)};
+	FileDescriptor treeFile{::open(tree.c_str(), O_RDONLY | O_CLOEXEC)};
+	if (dataFile.fd < 0 || treeFile.fd < 0)
+		throw Verity::Exception(errno, std::system_category());
+
+	unsigned char header[HeaderSize];
+	ReadAll<Verity::Exception>(treeFile.fd, header, HeaderSize, 0);
+	mBlockSize = std::uint32_t{header[0]} << 24 | std::uint32_t{header[1]} << 16 | std::uint32_t{header[2]} << 8 | header[3];
+	std::size_t digestSize = std::uint32_t{header[4]} << 24 | std::uint32_t{header[5]} << 16 | std::uint32_t{header[6]} << 8 | header[7];
+	for (int i = 8; i < 16; ++i)
+		mDataSize = mDataSize << 8 | header[i];
+
+	mLevelSizes = LevelSizes(mBlockSize ? (mDataSize + mBlockSize - 1) / mBlockSize : 0);
+	std::uint64_t treeSize = HeaderSize;
+	for (auto levelSize : mLevelSizes) {
+		mLevelOffsets.push_back(treeSize);
+		treeSize += levelSize * mDigestSize;
+	}
+	// the header is not authenticated yet, a block buffer is allocated from it
+	if (!mBlockSize || mBlockSize > Verity::MaxBlockSize || digestSize != mDigestSize || root.size() != mDigestSize
+			|| mDataSize != FileSize(dataFile.fd) || treeSize != FileSize(treeFile.fd))
+		throw Verity::Exception(std::make_error_code(std::errc::bad_message));
+
+	if (mLevelSizes.empty()) {
+		if (root != EmptyDigest(md))
+			throw Verity::Exception(std::make_error_code(std::errc::bad_message));
+	} else {
+		mVerified.emplace(NodeKey(mLevelSizes.size() - 1, 0), root);
+	}
+
+	mBlock.reset(new std::byte[mBlockSize]);
+	mData = std::exchange(dataFile.fd, -1);
+	mTree = std::exchange(treeFile.fd, -1);
+}
+
+VerityInput::VerityInput(VerityInput&& other) noexcept
+{ swap(*this, other); }
+
+void
+swap(VerityInput& a, VerityInput& b) noexcept
+{
+	std::swap(a.mMd, b.mMd);
+	std::swap(a.mData, b.mData);
+	std::swap(a.mTree, b.mTree);
+	std::swap(a.mBlockSize, b.mBlockSize);
+	std::swap(a.mDigestSize, b.mDigestSize);
+	std::swap(a.mDataSize, b.mDataSize);
+	std::swap(a.mLevelSizes, b.mLevelSizes);
+	std::swap(a.mLevelOffsets, b.mLevelOffsets);
+	std::swap(a.mVerified, b.mVerified);
+	std::swap(a.mCacheSize, b.mCacheSize);
+	std::swap(a.mBlock, b.mBlock);
+	std::swap(a.mBlockIndex, b.mBlockIndex);
+	std::swap(a.mPosition, b.mPosition);
+}
+
+VerityInput&
+VerityInput::operator=(VerityInput&& other) noexcept
+{
+	swap(*this, other);
+	return *this;
+}
+
+VerityInput::~VerityInput()
+{
+	if (mData >= 0)
+		::close(mData);
+	if (mTree >= 0)
+		::close(mTree);
+}
+
+void
+VerityInput::loadBlock(std::uint64_t index)
+{
+	mBlockIndex = -1;
+	std::size_t size = std::min<std::uint64_t>(mBlockSize, mDataSize - index * mBlockSize);
+	ReadAll<Exception>(mData, mBlock.get(), size, index * mBlockSize);
+
+	std::vector<std::byte> node(mDigestSize);
+	std::vector<std::byte> sibling(mDigestSize);
+	unsigned long error;
+	if (!DigestTree::Leaf(mMd, mBlock.get(), size, node.data(), error))
+		throw Exception(static_cast<Verity::Exception::Code>(error));
+
+	// hash up to the first verified node, the nodes on the way and their siblings are verified with it
+	std::vector<std::pair<std::uint64_t, std::vector<std::byte>>> path;
+	std::uint64_t i = index;
+	for (std::size_t level = 0;; ++level, i /= 2) {
+		if (auto it = mVerified.find(NodeKey(level, i)); it != mVerified.end()) {
+			if (CRYPTO_memcmp(it->second.data(), node.data(), mDigestSize))
+				throw Exception(std::make_error_code(std::errc::bad_message));
+			break;
+		}
+		path.emplace_back(NodeKey(level, i), node);
+		if ((i ^ 1) < mLevelSizes[level]) {
+			ReadAll<Exception>(mTree, sibling.data(), mDigestSize, mLevelOffsets[level] + (i ^ 1) * mDigestSize);
+			path.emplace_back(NodeKey(level, i ^ 1), sibling);
+			if (!(i & 1 ? DigestTree::Node(mMd, sibling.data(), node.data(), node.data(), error)
+					: DigestTree::Node(mMd, node.data(), sibling.data(), node.data(), error)))
+				throw Exception(static_cast<Verity::Exception::Code>(error));
+		}
+	}
+
+	if (mVerified.size() + path.size() > mCacheSize) {
+		auto rootKey = NodeKey(mLevelSizes.size() - 1, 0);
+		auto root = std::move(mVerified[rootKey]);
+		mVerified.clear();
+		mVerified.emplace(rootKey, std::move(root));
+	}
+	for (auto& verified : path)
+		mVerified.insert(std::move(verified));
+	mBlockIndex = index;
+}
+
+std::size_t
+VerityInput::readBytes(std::byte* dest, std::size_t size)
+{
+	if (mPosition >= mDataSize)
+		throw Exception(std::make_error_code(std::errc::no_message_available));
+
+	std::uint64_t index = mPosition / mBlockSize;
+	if (index != mBlockIndex)
+		loadBlock(index);
+
+	std::size_t offset = mPosition - index * mBlockSize;
+	size = std::min<std::uint64_t>({size, mBlockSize - offset, mDataSize - mPosition});
+	std::memcpy(dest, mBlock.get() + offset, size);
+	mPosition += size;
+	return size;
+}
+
+std::uint64_t
+VerityInput::getSize() const noexcept
+{ return mDataSize; }
+
+std::uint64_t
+VerityInput::getPosition() const noexcept
+{ return mPosition; }
+
+void
+VerityInput::setPosition(std::uint64_t position) noexcept
+{ mPosition = position; }
+
+std::vector<std::byte>
+Verity::Build(EVP_MD const* md, std::string const& src, std::string const& tree, std::size_t blockSize, WorkerPool& pool)
+{
+	if (!blockSize || blockSize > MaxBlockSize)
+		throw Exception(std::make_error_code(std::errc::invalid_argument));
+
+	FileDescriptor in{::open(src.c_str(), O_RDONLY | O_CLOEXEC)};
+	if (in.fd < 0)
+		throw Exception(errno, std::system_category());
+	std::uint64_t dataSize = FileSize(in.fd);
+	std::size_t digestSize = EVP_MD_size(md);
+	auto levelSizes = LevelSizes((dataSize + blockSize - 1) / blockSize);
+
+	std::vector<std::byte> level(levelSizes.empty() ? 0 : levelSizes[0] * digestSize);
+	{
+		// enough blocks to keep every worker and the calling thread busy
+		std::size_t batchBlocks = 64 * (pool.getThreadCount() + 1);
+		std::unique_ptr<std::byte[]> batch(new std::byte[batchBlocks * blockSize]);
+		for (std::uint64_t offset = 0; offset < dataSize; offset += batchBlocks * blockSize) {
+			std::size_t size = std::min<std::uint64_t>(batchBlocks * blockSize, dataSize - offset);
+			ReadAll<Exception>(in.fd, batch.get(), size, offset);
+			std::byte* hashes = level.data() + offset / blockSize * digestSize;
+			pool.run((size + blockSize - 1) / blockSize, [&](std::size_t i) {
+				unsigned long error;
+				if (!DigestTree::Leaf(md, batch.get() + i * blockSize, std::min(blockSize, size - i * blockSize),
+						hashes + i * digestSize, error))
+					throw Exception(static_cast<Exception::Code>(error));
+			});
+		}
+	}
+
+	FileDescriptor out{::open(tree.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)};
+	if (out.fd < 0)
+		throw Exception(errno, std::system_category());
+	unsigned char header[HeaderSize];
+	for (int i = 0; i < 4; ++i) {
+		header[i] = blockSize >> (24 - 8 * i);
+		header[4 + i] = digestSize >> (24 - 8 * i);
+	}
+	for (int i = 0; i < 8; ++i)
+		header[8 + i] = dataSize >> (56 - 8 * i);
+	WriteAll(out.fd, header, HeaderSize);
+
+	if (levelSizes.empty())
+		return EmptyDigest(md);
+
+	for (std::size_t l = 0;; ++l) {
+		WriteAll(out.fd, level.data(), level.size());
+		if (l + 1 == levelSizes.size())
+			return level;
+		std::vector<std::byte> next(levelSizes[l + 1] * digestSize);
+		for (std::uint64_t i = 0; i < levelSizes[l + 1]; ++i) {
+			unsigned long error;
+			if (2 * i + 1 < levelSizes[l]) {
+				if (!DigestTree::Node(md, level.data() + 2 * i * digestSize, level.data() + (2 * i + 1) * digestSize,
+						next.data() + i * digestSize, error))
+					throw Exception(static_cast<Exception::Code>(error));
+			} else
+				std::memcpy(next.data() + i * digestSize, level.data() + 2 * i * digestSize, digestSize);
+		}
+		level = std::move(next);
+	}
+}
+
+std::error_code
+make_error_code(Verity::Exception::Code e) noexcept
+{
+	static struct : std::error_category {
+		[[nodiscard]] char const*
+		name() const noexcept override
+		{ return "Security::Verity"; }
+
+		[[nodiscard]] std::string
+		message(int ev) const noexcept override
+		{ return ERR_error_string(ev, nullptr); }
+	} const cat;
+	return {static_cast<int>(e), cat};
+}
+
+}//namespace Security
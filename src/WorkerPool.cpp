@@ -0,0 +1,124 @@
+#include "Security/WorkerPool.hpp"
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace Security {
+
+WorkerPool&
+WorkerPool::Default()
+{
+	static WorkerPool pool;
+	return pool;
+}
+
+WorkerPool::WorkerPool(unsigned threadCount)
+{
+	if (!threadCount)
+		threadCount = 1;
+	mThreads.reserve(threadCount);
+	for (unsigned i = 0; i < threadCount; ++i)
+		mThreads.emplace_back(&WorkerPool::work, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard lock{mMutex};
+		mStop = true;
+	}
+	mCondition.notify_all();
+	for (auto& thread : mThreads)
+		thread.join();
+}
+
+void
+WorkerPool::work()
+{
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock lock{mMutex};
+			mCondition.wait(lock, [this] { return mStop || !mTasks.empty(); });
+			if (mTasks.empty())
+				return;
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+		}
+		try {
+			task();
+		} catch (...) {}
+	}
+}
+
+unsigned
+WorkerPool::getThreadCount() const noexcept
+{ return static_cast<unsigned>(mThreads.size()); }
+
+void
+WorkerPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard lock{mMutex};
+		mTasks.push_back(std::move(task));
+	}
+	mCondition.notify_one();
+}
+
+void
+WorkerPool::run(std::size_t count, std::function<void(std::size_t)> const& task)
+{
+	struct State {
+		std::function<void(std::size_t)> const& task;
+		std::size_t count;
+		std::atomic<std::size_t> next = 0;
+		std::size_t active = 0;
+		std::exception_ptr error;
+		std::mutex mutex;
+		std::condition_variable done;
+
+		void
+		drain()
+		{
+			for (std::size_t i; (i = next++) < count;) {
+				try {
+					task(i);
+				} catch (...) {
+					std::lock_guard lock{mutex};
+					if (!error)
+						error = std::current_exception();
+				}
+			}
+		}
+	};
+
+	if (!count)
+		return;
+
+	auto state = std::make_shared<State>(task, count);
+	// helpers that start after the calling thread has drained the indices do nothing,
+	// so a nested run never waits for a task stuck behind busy workers
+	std::size_t helperCount = std::min<std::size_t>(count, mThreads.size() + 1) - 1;
+	for (std::size_t i = 0; i < helperCount; ++i) {
+		submit([state] {
+			{
+				std::lock_guard lock{state->mutex};
+				if (state->next >= state->count)
+					return;
+				++state->active;
+			}
+			state->drain();
+			std::lock_guard lock{state->mutex};
+			if (!--state->active)
+				state->done.notify_all();
+		});
+	}
+
+	state->drain();
+	std::unique_lock lock{state->mutex};
+	state->done.wait(lock, [&] { return !state->active; });
+	if (state->error)
+		std::rethrow_exception(state->error);
+}
+
+}//namespace Security
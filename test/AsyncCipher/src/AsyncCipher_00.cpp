@@ -0,0 +1,69 @@
+#include <Security/AsyncCipher.hpp>
+#include <Security/Cipher.hpp>
+#include <Stream/Buffer.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <openssl/rand.h>
+#include <cassert>
+#include <iostream>
+#include <openssl/err.h>
+
+#define Expect1(x) if (1 != x) throw std::runtime_error(ERR_error_string(ERR_peek_last_error(), nullptr))
+
+std::vector<std::byte>
+readAll(Stream::Pipe& pipe, std::size_t size)
+{
+	std::vector<std::byte> data;
+	data.resize(size);
+	pipe.read(data.data(), data.size());
+	return data;
+}
+
+void
+test(std::string const& name, EVP_CIPHER const* cipher, std::size_t bufferSize, int length, int maxChunkLength)
+{
+	Security::Secret<> secretKey{static_cast<std::size_t>(EVP_CIPHER_key_length(cipher))};
+	Expect1(RAND_priv_bytes(secretKey.get(), secretKey.size()));
+	std::byte iv[EVP_MAX_IV_LENGTH];
+	Expect1(RAND_bytes(reinterpret_cast<unsigned char*>(iv), EVP_MAX_IV_LENGTH));
+
+	std::vector<std::byte> plain = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+	std::size_t encryptedSize = EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER
+			? plain.size() + EVP_GCM_TLS_TAG_LEN
+			: (plain.size() / EVP_CIPHER_block_size(cipher) + (EVP_CIPHER_block_size(cipher) > 1)) * EVP_CIPHER_block_size(cipher);
+
+	Stream::Pipe serial;
+	{
+		Security::CipherEncrypt encryptor{cipher, secretKey, iv};
+		serial < encryptor;
+		encryptor.write(plain.data(), plain.size());
+		encryptor.finalizeEncryption();
+		encryptor.flush();
+	}
+
+	Stream::Pipe async;
+	{
+		Stream::BufferOutput buffer{4096};
+		async < buffer;
+		Security::AsyncCipherEncrypt encryptor{cipher, secretKey, iv, bufferSize};
+		buffer < encryptor;
+		StreamTest::WriteRandomChunks(encryptor, plain,
+				std::uniform_int_distribution<int> {1, maxChunkLength});
+		encryptor.finalizeEncryption();
+		encryptor.flush();
+		std::cout << name << " worker cpu time: " << encryptor.getWorkerCpuTime().count() << " ns" << std::endl;
+	}
+
+	assert(readAll(serial, encryptedSize) == readAll(async, encryptedSize));
+}
+
+int main()
+{
+	int length = 1024*1024*4;
+	int maxChunkLength = 1024*64;
+
+	test("cbc", EVP_aes_256_cbc(), 64*1024, length + 7, maxChunkLength);
+	test("ctr", EVP_aes_128_ctr(), 1000, length + 13, maxChunkLength);
+	test("gcm", EVP_aes_256_gcm(), 256*1024, length, maxChunkLength);
+	return 0;
+}
@@ -0,0 +1,132 @@
+#include <Security/Checkpoint.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+std::vector<std::byte>
+drain(Stream::Pipe& pipe)
+{
+	std::vector<std::byte> container;
+	std::byte buffer[4096];
+	try {
+		for (;;) {
+			auto size = pipe.readSome(buffer, sizeof buffer);
+			container.insert(container.end(), buffer, buffer + size);
+		}
+	} catch (Stream::Input::Exception const& exc) {
+		assert(exc.code() == std::errc::no_message_available);
+	}
+	return container;
+}
+
+void
+test(EVP_MD const* md, Security::Key const& key, std::uint32_t interval, std::size_t length, int maxChunkLength)
+{
+	std::vector<std::byte> data = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+
+	Stream::Pipe pipe;
+	std::uint64_t checkpoints;
+	{
+		Security::CheckpointOutput checkpointOutput{md, key, interval};
+		pipe < checkpointOutput;
+		StreamTest::WriteRandomChunks(checkpointOutput, data,
+				std::uniform_int_distribution<int> {1, maxChunkLength});
+		checkpointOutput.checkpoint();
+		checkpointOutput.flush();
+		checkpoints = checkpointOutput.getCheckpointCount();
+		assert(checkpoints == (length + interval - 1) / interval);
+	}
+	std::vector<std::byte> container = drain(pipe);
+
+	std::vector<std::byte> read(data.size());
+	pipe.write(container.data(), container.size());
+	Security::CheckpointInput checkpointInput{md, key};
+	pipe > checkpointInput;
+	StreamTest::ReadRandomChunks(checkpointInput, read,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	assert(read == data);
+	assert(checkpointInput.getCheckpointCount() == checkpoints);
+
+	// data before the tampered checkpoint is released, the rest is not
+	if (length > interval) {
+		std::vector<std::byte> tampered = container;
+		tampered[tampered.size() - 1] ^= std::byte{1};
+		pipe.write(tampered.data(), tampered.size());
+		Security::CheckpointInput tamperedInput{md, key};
+		pipe > tamperedInput;
+		std::size_t verified = (length - 1) / interval * interval;
+		tamperedInput.read(read.data(), verified);
+		try {
+			tamperedInput.read(read.data(), 1);
+			assert(false);
+		} catch (Security::CheckpointInput::Exception const& exc) {
+			assert(exc.code() == std::errc::bad_message);
+		}
+		drain(pipe);
+	}
+
+	// truncated after data
+	pipe.write(container.data(), container.size() - 1);
+	Security::CheckpointInput truncatedInput{md, key};
+	pipe > truncatedInput;
+	try {
+		truncatedInput.read(read.data(), read.size());
+		assert(false);
+	} catch (Security::CheckpointInput::Exception const& exc) {
+		assert(exc.code() == std::errc::bad_message);
+	}
+
+	// an interval above the limit is rejected before it is allocated
+	if (interval > 1) {
+		pipe.write(container.data(), container.size());
+		Security::CheckpointInput limitedInput{md, key, interval - 1};
+		pipe > limitedInput;
+		try {
+			limitedInput.read(read.data(), read.size());
+			assert(false);
+		} catch (Security::CheckpointInput::Exception const& exc) {
+			assert(exc.code() == std::errc::bad_message);
+		}
+		drain(pipe);
+	}
+
+	std::cout << EVP_MD_get0_name(md ? md : EVP_sha512()) << " " << interval << ": " << checkpoints << " checkpoints, "
+			<< container.size() - length << " bytes overhead" << std::endl;
+}
+
+void
+testPeriod(Security::Key const& key)
+{
+	Stream::Pipe pipe;
+	Security::Checkpoint checkpoint{nullptr, key, 1024*1024, std::chrono::milliseconds{5}};
+	pipe < static_cast<Security::CheckpointOutput&>(checkpoint);
+	pipe > static_cast<Security::CheckpointInput&>(checkpoint);
+
+	std::byte message[16]{};
+	std::byte received[16];
+	for (int i = 0; i < 4; ++i) {
+		std::this_thread::sleep_for(std::chrono::milliseconds{10});
+		message[0] = static_cast<std::byte>(i);
+		checkpoint.write(message, sizeof message);
+		checkpoint.flush();
+		// each message is signed on its own although the interval is far from reached
+		assert(checkpoint.CheckpointOutput::getCheckpointCount() == static_cast<std::uint64_t>(i) + 1);
+		checkpoint.read(received, sizeof received);
+		assert(!std::memcmp(message, received, sizeof message));
+	}
+	assert(checkpoint.CheckpointInput::getCheckpointCount() == 4);
+}
+
+int main()
+{
+	Security::Key ec{Security::Key::EC::prime256v1};
+	Security::Key ed{Security::Key::ED::ED25519};
+	test(EVP_sha256(), ec, 64*1024, 1024*1024 + 123, 1024*16);
+	test(nullptr, ed, 1000, 1024*100, 4096);
+	test(EVP_sha384(), Security::Key{Security::Key::RSA::RSA3072}, 4096, 4096, 100);
+	testPeriod(ed);
+	return 0;
+}
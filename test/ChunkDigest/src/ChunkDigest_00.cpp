@@ -0,0 +1,92 @@
+#include <Security/ChunkDigest.hpp>
+#include <Security/Digest.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <cassert>
+#include <iostream>
+#include <set>
+
+struct Chunk {
+	std::uint64_t offset;
+	std::size_t size;
+	std::vector<std::byte> digest;
+};
+
+Security::ContentChunker::Callback
+collect(std::vector<Chunk>& chunks)
+{
+	return [&chunks](std::uint64_t offset, std::size_t size, std::span<std::byte const> digest) {
+		chunks.push_back({offset, size, std::vector<std::byte>(digest.begin(), digest.end())});
+	};
+}
+
+void
+check(std::vector<Chunk> const& chunks, std::vector<std::byte> const& data, EVP_MD const* md, std::size_t averageSize)
+{
+	std::uint64_t offset = 0;
+	for (std::size_t i = 0; i < chunks.size(); ++i) {
+		assert(chunks[i].offset == offset);
+		assert(chunks[i].size <= averageSize * 8);
+		assert(chunks[i].size >= averageSize / 4 || i + 1 == chunks.size());
+		assert(Security::Digest::Matches(chunks[i].digest,
+				Security::Digest::Compute(data.data() + offset, chunks[i].size, md)));
+		offset += chunks[i].size;
+	}
+	assert(offset == data.size());
+}
+
+void
+test(EVP_MD const* md, std::size_t averageSize, std::size_t length, int maxChunkLength)
+{
+	std::vector<std::byte> data = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+
+	std::vector<Chunk> outputChunks;
+	Stream::Pipe pipe;
+	Security::ChunkDigestOutput chunkOutput{md, collect(outputChunks), averageSize};
+	pipe < chunkOutput;
+	StreamTest::WriteRandomChunks(chunkOutput, data,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	chunkOutput.finalizeOutputChunk();
+	check(outputChunks, data, md, averageSize);
+
+	std::vector<Chunk> inputChunks;
+	std::vector<std::byte> read(data.size());
+	Security::ChunkDigestInput chunkInput{md, collect(inputChunks), averageSize};
+	pipe > chunkInput;
+	StreamTest::ReadRandomChunks(chunkInput, read,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	chunkInput.finalizeInputChunk();
+	assert(read == data);
+	assert(inputChunks.size() == outputChunks.size());
+	for (std::size_t i = 0; i < inputChunks.size(); ++i)
+		assert(inputChunks[i].size == outputChunks[i].size && inputChunks[i].digest == outputChunks[i].digest);
+
+	// boundaries follow the content, inserting bytes at the beginning keeps most of the chunks
+	std::vector<std::byte> shifted = StreamTest::GetRandomBytes<std::chrono::minutes>(100);
+	shifted.insert(shifted.end(), data.begin(), data.end());
+	std::vector<Chunk> shiftedChunks;
+	Security::ChunkDigestOutput shiftedOutput{md, collect(shiftedChunks), averageSize};
+	pipe < shiftedOutput;
+	shiftedOutput.write(shifted.data(), shifted.size());
+	shiftedOutput.finalizeOutputChunk();
+	check(shiftedChunks, shifted, md, averageSize);
+
+	std::set<std::vector<std::byte>> digests;
+	for (auto const& chunk : outputChunks)
+		digests.insert(chunk.digest);
+	std::size_t common = 0;
+	for (auto const& chunk : shiftedChunks)
+		common += digests.count(chunk.digest);
+	assert(outputChunks.size() < 4 || common + 3 >= outputChunks.size());
+
+	std::cout << "average " << averageSize << ": " << outputChunks.size() << " chunks of " << length / std::max<std::size_t>(outputChunks.size(), 1)
+			<< " bytes, " << common << " unchanged after shift" << std::endl;
+}
+
+int main()
+{
+	test(EVP_sha256(), 1024, 1024*512, 4096);
+	test(EVP_sha256(), 8*1024, 1024*1024*2, 1024*64);
+	test(EVP_sha1(), 4*1024, 100, 10);
+	return 0;
+}
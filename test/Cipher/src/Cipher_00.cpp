@@ -1,8 +1,10 @@
 #include <Security/Cipher.hpp>
 #include <Stream/File.hpp>
+#include <Stream/Pipe.hpp>
 #include <StreamTest/Util.hpp>
 #include <openssl/rand.h>
 #include <cassert>
+#include <filesystem>
 #include <openssl/err.h>
 
 #define Expect1(x) if (1 != x) throw std::runtime_error(ERR_error_string(ERR_peek_last_error(), nullptr))
@@ -43,6 +45,8 @@ testEncrypt(std::string const& fileName, EVP_CIPHER const* cipher, int length, i
 
 	Security::CipherEncrypt encryptor{cipher, secretKey, iv.get()};
 	buffer < encryptor;
+	if (EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER)
+		encryptor.updateAAD(fileName.data(), fileName.size());
 
 	StreamTest::WriteRandomChunks(encryptor, toEncrypt,
 			std::uniform_int_distribution<int> {1, maxChunkLength});
@@ -50,7 +54,8 @@ testEncrypt(std::string const& fileName, EVP_CIPHER const* cipher, int length, i
 }
 
 std::vector<std::byte>
-testDecrypt(std::string const& fileName, EVP_CIPHER const* cipher, int length, int maxChunkLength)
+testDecrypt(std::string const& fileName, EVP_CIPHER const* cipher, int length, int maxChunkLength,
+		std::size_t readAheadSize = 0)
 {
 	auto secretKey = readSecretKey(fileName);
 	std::unique_ptr<std::byte[]> iv;
@@ -68,12 +73,198 @@ testDecrypt(std::string const& fileName, EVP_CIPHER const* cipher, int length, i
 
 	Security::CipherDecrypt decryptor{cipher, secretKey, iv.get()};
 	buffer > decryptor;
+	if (EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER)
+		decryptor.updateAAD(fileName.data(), fileName.size());
+	if (readAheadSize)
+		decryptor.setReadAheadSize(readAheadSize);
 
 	StreamTest::ReadRandomChunks(decryptor, decrypted,
 			std::uniform_int_distribution<int> {1, maxChunkLength});
+	decryptor.finalizeDecryption();
 	return decrypted;
 }
 
+void
+testTamper(std::string const& fileName, EVP_CIPHER const* cipher, int length)
+{
+	{
+		Stream::File file{fileName, Stream::File::Mode::R};
+		std::vector<std::byte> data;
+		data.resize(file.getFileSize());
+		file.read(data.data(), data.size());
+		data[data.size() / 2] ^= std::byte{1};
+		Stream::File{fileName, Stream::File::Mode::W}.write(data.data(), data.size());
+	}
+	try {
+		testDecrypt(fileName, cipher, length, length);
+		assert(false);
+	} catch (Security::CipherDecrypt::Exception const& exc) {
+		assert(exc.code() == std::make_error_code(std::errc::bad_message));
+	}
+}
+
+void
+testUnreleased(EVP_CIPHER const* cipher, int length, int maxChunkLength)
+{
+	Security::Secret<> secretKey{static_cast<std::size_t>(EVP_CIPHER_key_length(cipher))};
+	Expect1(RAND_priv_bytes(secretKey.get(), secretKey.size()));
+	std::vector<std::byte> iv(EVP_CIPHER_iv_length(cipher));
+	std::vector<std::byte> plain = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+
+	Stream::Pipe pipe;
+	{
+		Security::CipherEncrypt encryptor{cipher, secretKey, iv.data()};
+		pipe < encryptor;
+		encryptor.write(plain.data(), plain.size());
+		encryptor.finalizeEncryption();
+	}
+	std::vector<std::byte> encrypted(length + 16);
+	pipe.read(encrypted.data(), encrypted.size());
+	encrypted[length - 1] ^= std::byte{1};
+	pipe.write(encrypted.data(), encrypted.size());
+
+	// the plaintext is read short of the tag, the forged end must not be released
+	Security::CipherDecrypt decryptor{cipher, secretKey, iv.data()};
+	pipe > decryptor;
+	std::vector<std::byte> decrypted(length);
+	std::size_t released = 0;
+	try {
+		while (released < decrypted.size())
+			released += decryptor.readSome(decrypted.data() + released,
+					std::min<std::size_t>(maxChunkLength, decrypted.size() - released));
+		assert(false);
+	} catch (Security::CipherDecrypt::Exception const& exc) {
+		assert(exc.code() == std::make_error_code(std::errc::bad_message));
+	}
+	assert(released < decrypted.size());
+	assert(std::equal(decrypted.begin(), decrypted.begin() + static_cast<std::ptrdiff_t>(released), plain.begin()));
+}
+
+void
+testSeek(std::string const& fileName, EVP_CIPHER const* cipher, std::vector<std::byte> const& plain)
+{
+	auto secretKey = readSecretKey(fileName);
+	std::vector<std::byte> encrypted;
+	{
+		Stream::File file{fileName, Stream::File::Mode::R};
+		encrypted.resize(file.getFileSize());
+		file.read(encrypted.data(), encrypted.size());
+	}
+	int ivLength = EVP_CIPHER_iv_length(cipher);
+
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	for (int i = 0; i < 16; ++i) {
+		auto offset = std::uniform_int_distribution<std::size_t>{0, plain.size()}(gen);
+		Stream::Pipe pipe;
+		pipe.write(encrypted.data() + ivLength + offset, plain.size() - offset);
+
+		Security::CipherDecrypt decryptor{cipher, secretKey, encrypted.data()};
+		pipe > decryptor;
+		decryptor.seek(offset);
+
+		std::vector<std::byte> decrypted;
+		decrypted.resize(plain.size() - offset);
+		decryptor.read(decrypted.data(), decrypted.size());
+		assert(std::equal(decrypted.begin(), decrypted.end(), plain.begin() + static_cast<std::ptrdiff_t>(offset)));
+	}
+}
+
+void
+testReset(EVP_CIPHER const* cipher, std::vector<std::byte> const& plain)
+{
+	Security::Secret<> keys[2]{
+		Security::Secret<>{static_cast<std::size_t>(EVP_CIPHER_key_length(cipher))},
+		Security::Secret<>{static_cast<std::size_t>(EVP_CIPHER_key_length(cipher))}};
+	std::byte ivs[3][EVP_MAX_IV_LENGTH];
+	for (auto& key : keys)
+		Expect1(RAND_priv_bytes(key.get(), static_cast<int>(key.size())));
+	Expect1(RAND_bytes(reinterpret_cast<unsigned char*>(ivs), sizeof(ivs)));
+	// a message with the same key needs an iv
+	bool hasIv = EVP_CIPHER_iv_length(cipher);
+	Security::Secret<> const* messageKeys[3]{&keys[0], &keys[hasIv ? 0 : 1], &keys[hasIv ? 1 : 0]};
+
+	Stream::Pipe pipes[3];
+	{
+		Security::CipherEncrypt encryptor{cipher, keys[0], ivs[0]};
+		for (int i = 0; i < 3; ++i) {
+			if (i && messageKeys[i] == messageKeys[i - 1])
+				encryptor.reset(ivs[i]);
+			else if (i)
+				encryptor.reset(*messageKeys[i], ivs[i]);
+			pipes[i] < encryptor;
+			encryptor.write(plain.data(), plain.size());
+			encryptor.finalizeEncryption();
+			encryptor.flush();
+		}
+	}
+
+	Security::CipherDecrypt decryptor{cipher, *messageKeys[2], ivs[2]};
+	for (int i = 2; i >= 0; --i) {
+		if (i != 2)
+			decryptor.reset(*messageKeys[i], ivs[i]);
+		pipes[i] > decryptor;
+		std::vector<std::byte> decrypted;
+		decrypted.resize(plain.size());
+		decryptor.read(decrypted.data(), decrypted.size());
+		decryptor.finalizeDecryption();
+		assert(decrypted == plain);
+	}
+}
+
+std::vector<std::byte>
+readFile(std::string const& fileName)
+{
+	Stream::File file{fileName, Stream::File::Mode::R};
+	std::vector<std::byte> data;
+	data.resize(file.getFileSize());
+	file.read(data.data(), data.size());
+	return data;
+}
+
+void
+testFile(std::string const& fileName, EVP_CIPHER const* cipher, std::vector<std::byte> const& plain)
+{
+	auto secretKey = readSecretKey(fileName);
+	auto encrypted = readFile(fileName);
+	int ivLength = EVP_CIPHER_iv_length(cipher);
+	Stream::File{fileName + ".plain", Stream::File::Mode::W}.write(plain.data(), plain.size());
+
+	auto size = Security::Cipher::EncryptFile(cipher, secretKey, encrypted.data(), fileName + ".plain", fileName + ".mmap");
+	auto mapped = readFile(fileName + ".mmap");
+	assert(size == mapped.size());
+	if (!(EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER)) // no aad
+		assert(std::equal(mapped.begin(), mapped.end(), encrypted.begin() + ivLength, encrypted.end()));
+
+	size = Security::Cipher::DecryptFile(cipher, secretKey, encrypted.data(), fileName + ".mmap", fileName + ".plain");
+	assert(size == plain.size() && readFile(fileName + ".plain") == plain);
+
+	if (EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER) {
+		mapped[mapped.size() / 2] ^= std::byte{1};
+		Stream::File{fileName + ".mmap", Stream::File::Mode::W}.write(mapped.data(), mapped.size());
+		try {
+			Security::Cipher::DecryptFile(cipher, secretKey, encrypted.data(), fileName + ".mmap", fileName + ".plain");
+			assert(false);
+		} catch (Security::Cipher::Exception const& exc) {
+			assert(exc.code() == std::make_error_code(std::errc::bad_message));
+		}
+		assert(!std::filesystem::exists(fileName + ".plain"));
+	}
+
+	// in place would truncate the input before reading it
+	try {
+		Security::Cipher::EncryptFile(cipher, secretKey, encrypted.data(), fileName + ".mmap", fileName + ".mmap");
+		assert(false);
+	} catch (Security::Cipher::Exception const& exc) {
+		assert(exc.code() == std::make_error_code(std::errc::invalid_argument));
+	}
+	assert(std::filesystem::file_size(fileName + ".mmap") == mapped.size());
+
+	Stream::File{fileName + ".empty", Stream::File::Mode::W};
+	size = Security::Cipher::EncryptFile(cipher, secretKey, encrypted.data(), fileName + ".empty", fileName + ".mmap");
+	assert(size == readFile(fileName + ".mmap").size());
+}
+
 void
 test(std::string const& fileName, EVP_CIPHER const* cipher, int length, int maxChunkLength)
 {
@@ -81,6 +272,15 @@ test(std::string const& fileName, EVP_CIPHER const* cipher, int length, int maxC
 	auto encrypt = testEncrypt(fileName, cipher, length, maxChunkLength);
 	auto decrypt = testDecrypt(fileName, cipher, length, maxChunkLength);
 	assert(encrypt == decrypt);
+	assert(encrypt == testDecrypt(fileName, cipher, length, maxChunkLength, 4096));
+	testReset(cipher, encrypt);
+	testFile(fileName, cipher, encrypt);
+	if (EVP_CIPHER_mode(cipher) == EVP_CIPH_CTR_MODE)
+		testSeek(fileName, cipher, encrypt);
+	if (EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER) {
+		testTamper(fileName, cipher, length);
+		testUnreleased(cipher, length, maxChunkLength);
+	}
 }
 
 int main()
@@ -103,6 +303,12 @@ int main()
 	length += std::uniform_int_distribution<int>{1, EVP_CIPHER_block_size(EVP_aes_128_ofb()) > 1 ? EVP_CIPHER_block_size(EVP_aes_128_ofb()) : EVP_MAX_BLOCK_LENGTH}(gen);
 	test("ofb.enc", EVP_aes_128_ofb(), length, maxChunkLength);
 
+	length += std::uniform_int_distribution<int>{1, EVP_MAX_BLOCK_LENGTH}(gen);
+	test("gcm.enc", EVP_aes_256_gcm(), length, maxChunkLength);
+
+	length += std::uniform_int_distribution<int>{1, EVP_MAX_BLOCK_LENGTH}(gen);
+	test("chacha20poly1305.enc", EVP_chacha20_poly1305(), length, maxChunkLength);
+
 	//	length += std::uniform_int_distribution<int>{1, EVP_CIPHER_block_size(EVP_aes_maxChunkLength_wrap()) > 1 ? EVP_CIPHER_block_size(EVP_aes_maxChunkLength_wrap()) : EVP_MAX_BLOCK_LENGTH}(gen);
 	//test("wrap.enc", EVP_aes_maxChunkLength_wrap(), length, maxChunkLength);
 
@@ -0,0 +1,157 @@
+#include <Security/Cipher.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+struct Object {
+	std::vector<std::byte> plain;
+	std::vector<std::byte> encrypted;
+};
+
+std::size_t
+encryptedSize(EVP_CIPHER const* cipher, std::size_t size)
+{
+	if (EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER)
+		return size + EVP_GCM_TLS_TAG_LEN;
+	if (int blockSize = EVP_CIPHER_block_size(cipher); blockSize > 1)
+		return (size / blockSize + 1) * blockSize;
+	return size;
+}
+
+std::vector<Object>
+encryptObjects(EVP_CIPHER const* cipher, Security::Secret<> const& key, std::byte const* iv, int count, int maxLength)
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	std::vector<Object> objects(count);
+	for (auto& object : objects) {
+		object.plain = StreamTest::GetRandomBytes<std::chrono::nanoseconds>(
+				std::uniform_int_distribution<int>{1, maxLength}(gen));
+		object.encrypted.resize(encryptedSize(cipher, object.plain.size()));
+
+		Stream::Pipe pipe;
+		Security::CipherEncrypt encryptor{cipher, key, iv};
+		pipe < encryptor;
+		encryptor.write(object.plain.data(), object.plain.size());
+		encryptor.finalizeEncryption();
+		encryptor.flush();
+		pipe.read(object.encrypted.data(), object.encrypted.size());
+	}
+	return objects;
+}
+
+std::chrono::nanoseconds
+decryptObjects(EVP_CIPHER const* cipher, Security::Secret<> const& key, std::byte const* iv,
+		std::vector<Object> const& objects, bool knownSize)
+{
+	std::vector<std::byte> decrypted;
+	auto start = std::chrono::steady_clock::now();
+	for (auto const& object : objects) {
+		Stream::Pipe pipe;
+		pipe.write(object.encrypted.data(), object.encrypted.size());
+
+		Security::CipherDecrypt decryptor{cipher, key, iv};
+		pipe > decryptor;
+		if (knownSize)
+			decryptor.setInputSize(object.encrypted.size());
+
+		// both read until the end, one more byte of room lets a read run into it
+		decrypted.resize(object.plain.size() + 1);
+		std::size_t size = 0;
+		if (knownSize) {
+			while (!decryptor.atEnd())
+				size += decryptor.readSome(decrypted.data() + size, decrypted.size() - size);
+		} else {
+			try {
+				for (;;)
+					size += decryptor.readSome(decrypted.data() + size, decrypted.size() - size);
+			} catch (Stream::Input::Exception const& exc) {
+				assert(exc.code() == std::make_error_code(std::errc::no_message_available));
+			}
+		}
+		decrypted.resize(size);
+		assert(decrypted == object.plain);
+	}
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+}
+
+std::chrono::nanoseconds
+decryptBatch(EVP_CIPHER const* cipher, Security::Secret<> const& key, std::byte const* iv,
+		std::vector<Object> const& objects)
+{
+	std::vector<Security::Cipher::Job> jobs(objects.size());
+	std::vector<std::vector<std::byte>> decrypted(objects.size());
+	for (std::size_t i = 0; i < objects.size(); ++i) {
+		decrypted[i].resize(objects[i].encrypted.size());
+		jobs[i] = {&key, iv, nullptr, 0, objects[i].encrypted.data(), objects[i].encrypted.size(), decrypted[i].data()};
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	assert(!Security::Cipher::Decrypt(cipher, jobs));
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+	for (std::size_t i = 0; i < objects.size(); ++i) {
+		decrypted[i].resize(jobs[i].destSize);
+		assert(decrypted[i] == objects[i].plain);
+	}
+	return elapsed;
+}
+
+void
+testBatchEncrypt(EVP_CIPHER const* cipher, Security::Secret<> const& key, std::byte const* iv,
+		std::vector<Object> const& objects)
+{
+	std::vector<Security::Cipher::Job> jobs(objects.size());
+	std::vector<std::vector<std::byte>> encrypted(objects.size());
+	for (std::size_t i = 0; i < objects.size(); ++i) {
+		encrypted[i].resize(objects[i].plain.size() + EVP_MAX_BLOCK_LENGTH + EVP_GCM_TLS_TAG_LEN);
+		jobs[i] = {&key, iv, nullptr, 0, objects[i].plain.data(), objects[i].plain.size(), encrypted[i].data()};
+	}
+
+	Security::Cipher::Encrypt(cipher, jobs);
+	for (std::size_t i = 0; i < objects.size(); ++i) {
+		encrypted[i].resize(jobs[i].destSize);
+		assert(encrypted[i] == objects[i].encrypted);
+	}
+
+	if (EVP_CIPHER_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER) {
+		encrypted[0][0] ^= std::byte{1};
+		std::byte decrypted[1024];
+		std::fill(std::begin(decrypted), std::end(decrypted), std::byte{0xff});
+		Security::Cipher::Job job{&key, iv, nullptr, 0, encrypted[0].data(), encrypted[0].size(), decrypted};
+		assert(1 == Security::Cipher::Decrypt(cipher, {&job, 1}) && job.failed && !job.destSize);
+		assert(std::all_of(decrypted, decrypted + objects[0].plain.size(), [](std::byte b) { return b == std::byte{0}; }));
+	}
+}
+
+void
+test(std::string const& name, EVP_CIPHER const* cipher, int count, int maxLength)
+{
+	Security::Secret<> key{static_cast<std::size_t>(EVP_CIPHER_key_length(cipher))};
+	RAND_priv_bytes(key.get(), static_cast<int>(key.size()));
+	std::byte iv[EVP_MAX_IV_LENGTH];
+	RAND_bytes(reinterpret_cast<unsigned char*>(iv), EVP_MAX_IV_LENGTH);
+
+	auto objects = encryptObjects(cipher, key, iv, count, maxLength);
+	auto eof = decryptObjects(cipher, key, iv, objects, false);
+	auto known = decryptObjects(cipher, key, iv, objects, true);
+	auto batch = decryptBatch(cipher, key, iv, objects);
+	testBatchEncrypt(cipher, key, iv, objects);
+	std::cout << name << " end of source: " << eof.count() / count << " ns/object, known size: "
+			<< known.count() / count << " ns/object, batch: " << batch.count() / count << " ns/object" << std::endl;
+}
+
+int main()
+{
+	int count = 1024*16;
+	int maxLength = 256;
+
+	test("cbc", EVP_aes_128_cbc(), count, maxLength);
+	test("ctr", EVP_aes_128_ctr(), count, maxLength);
+	test("gcm", EVP_aes_128_gcm(), count, maxLength);
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include <Security/CipherPool.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <openssl/rand.h>
+#include <cassert>
+#include <openssl/err.h>
+#include <thread>
+
+#define Expect1(x) if (1 != x) throw std::runtime_error(ERR_error_string(ERR_peek_last_error(), nullptr))
+
+void
+test(EVP_CIPHER const* cipher, int messageCount, int maxLength)
+{
+	Security::Secret<> keys[2]{
+		Security::Secret<>{static_cast<std::size_t>(EVP_CIPHER_key_length(cipher))},
+		Security::Secret<>{static_cast<std::size_t>(EVP_CIPHER_key_length(cipher))}};
+	for (auto& key : keys)
+		Expect1(RAND_priv_bytes(key.get(), static_cast<int>(key.size())));
+
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	Security::CipherEncrypt const* encryptor = nullptr;
+	Security::CipherDecrypt const* decryptor = nullptr;
+	for (int i = 0; i < messageCount; ++i) {
+		auto const& key = keys[i % 2];
+		std::byte iv[EVP_MAX_IV_LENGTH];
+		Expect1(RAND_bytes(reinterpret_cast<unsigned char*>(iv), EVP_MAX_IV_LENGTH));
+		auto plain = StreamTest::GetRandomBytes<std::chrono::nanoseconds>(
+				std::uniform_int_distribution<int>{1, maxLength}(gen));
+
+		Stream::Pipe pipe;
+		{
+			auto lease = Security::CipherPool::Encrypt(cipher, key, iv);
+			pipe < *lease;
+			lease->write(plain.data(), plain.size());
+			if (i == 2) // released streams are handed out again
+				assert(encryptor == &*lease);
+			else if (!i)
+				encryptor = &*lease;
+		}
+
+		std::vector<std::byte> decrypted;
+		decrypted.resize(plain.size());
+		{
+			auto lease = Security::CipherPool::Decrypt(cipher, key, iv);
+			pipe > *lease;
+			lease->read(decrypted.data(), decrypted.size());
+			lease->finalizeDecryption();
+			if (i == 2)
+				assert(decryptor == &*lease);
+			else if (!i)
+				decryptor = &*lease;
+		}
+		assert(decrypted == plain);
+	}
+}
+
+int main()
+{
+	int messageCount = 256;
+	int maxLength = 1024;
+
+	std::vector<std::thread> threads;
+	for (auto* cipher : {EVP_aes_256_cbc(), EVP_aes_128_ctr(), EVP_aes_256_gcm(), EVP_chacha20_poly1305(), EVP_rc4()})
+		threads.emplace_back(test, cipher, messageCount, maxLength);
+	for (auto& thread : threads)
+		thread.join();
+	return 0;
+}
@@ -1,5 +1,6 @@
 #include <Stream/File.hpp>
 #include <Stream/Buffer.hpp>
+#include <Stream/Pipe.hpp>
 #include <Security/Digest.hpp>
 #include <cassert>
 #include <openssl/rand.h>
@@ -110,6 +111,33 @@ testCMAC(std::string const& fileName, Security::Key const& key, int length, int
 	assert(Security::Digest::Matches(outputCMAC, inputCMAC));
 }
 
+void
+testCheckpoint(EVP_MD const* md, int length, int maxChunkLength, std::uint64_t interval)
+{
+	std::vector<std::byte> outputData = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+
+	Stream::Pipe pipe;
+	Security::DigestOutput digestOutput(md);
+	pipe < digestOutput;
+
+	std::vector<std::pair<std::uint64_t, std::vector<std::byte>>> checkpoints;
+	digestOutput.setCheckpoint(interval, [&](std::uint64_t offset, std::span<std::byte const> digest) {
+		checkpoints.emplace_back(offset, std::vector<std::byte>(digest.begin(), digest.end()));
+	});
+
+	StreamTest::WriteRandomChunks(digestOutput, outputData,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+
+	assert(checkpoints.size() == length / interval);
+	for (std::size_t i = 0; i < checkpoints.size(); ++i) {
+		assert(checkpoints[i].first == (i + 1) * interval);
+		assert(Security::Digest::Matches(checkpoints[i].second,
+				Security::Digest::Compute(outputData.data(), checkpoints[i].first, md)));
+	}
+	assert(Security::Digest::Matches(digestOutput.getOutputDigest(),
+			Security::Digest::Compute(outputData.data(), outputData.size(), md)));
+}
+
 int main() {
 	std::random_device rd;
 	std::mt19937 gen(rd());
@@ -119,6 +147,8 @@ int main() {
 
 	length += std::uniform_int_distribution<int>{1, 5}(gen);
 	testHash("sha256.hash", EVP_sha256(), length, maxChunkLength);
+	testCheckpoint(EVP_sha256(), length, maxChunkLength, 4096);
+	testCheckpoint(EVP_sha256(), length, maxChunkLength, 100);
 
 	Security::Secret<> hKeyRaw(EVP_MD_size(EVP_sha256()));
 	Expect1(RAND_priv_bytes(hKeyRaw.get(), hKeyRaw.size()));
@@ -0,0 +1,106 @@
+#include <Stream/Pipe.hpp>
+#include <Security/Digest.hpp>
+#include <StreamTest/Util.hpp>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+void
+test(std::string const& name, EVP_MD const* md, int count, int minLength, int maxLength)
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	auto data = StreamTest::GetRandomBytes<std::chrono::nanoseconds>(static_cast<std::size_t>(count) * maxLength);
+	std::vector<std::span<std::byte const>> messages;
+	messages.reserve(count);
+	for (int i = 0; i < count; ++i)
+		messages.emplace_back(data.data() + static_cast<std::size_t>(i) * maxLength,
+				std::uniform_int_distribution<int>{minLength, maxLength}(gen));
+
+	std::size_t size = EVP_MD_size(md);
+	std::vector<std::byte> single(count * size);
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i) {
+		auto digest = Security::Digest::Compute(messages[i].data(), messages[i].size(), md);
+		std::memcpy(single.data() + i * size, digest.data(), size);
+	}
+	auto singleTime = std::chrono::steady_clock::now() - start;
+
+	std::vector<std::byte> batch(count * size);
+	start = std::chrono::steady_clock::now();
+	Security::Digest::Compute(messages, md, batch.data());
+	auto batchTime = std::chrono::steady_clock::now() - start;
+
+	assert(single == batch);
+	std::cout << name << " single: " << std::chrono::duration_cast<std::chrono::nanoseconds>(singleTime).count() / count
+			<< " ns/message, batch: " << std::chrono::duration_cast<std::chrono::nanoseconds>(batchTime).count() / count
+			<< " ns/message" << std::endl;
+}
+
+template <typename A>
+void
+testFixed(std::string const& name, EVP_MD const* md, int count, int length)
+{
+	auto data = StreamTest::GetRandomBytes<std::chrono::nanoseconds>(static_cast<std::size_t>(count) * length);
+
+	std::vector<std::byte> dynamic(count * A::Size);
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i) {
+		auto digest = Security::Digest::Compute(data.data() + static_cast<std::size_t>(i) * length, length, md);
+		std::memcpy(dynamic.data() + i * A::Size, digest.data(), A::Size);
+	}
+	auto dynamicTime = std::chrono::steady_clock::now() - start;
+
+	std::vector<std::byte> fixed(count * A::Size);
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+		Security::Digest::Compute<A>(data.data() + static_cast<std::size_t>(i) * length, length,
+				std::span<std::byte, A::Size>(fixed.data() + i * A::Size, A::Size));
+	auto fixedTime = std::chrono::steady_clock::now() - start;
+
+	assert(dynamic == fixed);
+	auto digest = Security::Digest::Compute<A>(data.data(), length);
+	assert(Security::Digest::Matches(digest, std::span<std::byte const>(fixed.data(), A::Size)));
+
+	Stream::Pipe pipe;
+	Security::DigestOutput digestOutput(md);
+	pipe < digestOutput;
+	digestOutput.write(data.data(), length);
+	std::array<std::byte, A::Size> current;
+	assert(digestOutput.getOutputDigest(current) == A::Size);
+	assert(Security::Digest::Matches(current, digest));
+
+	// the getters of an idle stream may be called from several threads
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; ++t)
+		readers.emplace_back([&] {
+			std::array<std::byte, A::Size> value;
+			for (int i = 0; i < 256; ++i) {
+				digestOutput.getOutputDigest(value);
+				assert(Security::Digest::Matches(value, digest));
+			}
+		});
+	for (auto& reader : readers)
+		reader.join();
+
+	std::cout << name << " vector: " << std::chrono::duration_cast<std::chrono::nanoseconds>(dynamicTime).count() / count
+			<< " ns/message, array: " << std::chrono::duration_cast<std::chrono::nanoseconds>(fixedTime).count() / count
+			<< " ns/message" << std::endl;
+}
+
+int main()
+{
+	int count = 1024*16;
+
+	test("sha1", EVP_sha1(), count, 1024, 4096);
+	test("sha256", EVP_sha256(), count, 1024, 4096);
+	test("sha256 small", EVP_sha256(), count, 1, 64);
+
+	testFixed<Security::SHA1>("sha1 fixed", EVP_sha1(), count, 32);
+	testFixed<Security::SHA256>("sha256 fixed", EVP_sha256(), count, 32);
+	testFixed<Security::SHA512>("sha512 fixed", EVP_sha512(), count, 32);
+	testFixed<Security::SHA3_256>("sha3-256 fixed", EVP_sha3_256(), count, 32);
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include <Security/DigestTree.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <cassert>
+#include <openssl/err.h>
+
+#define Expect1(x) if (1 != x) throw std::runtime_error(ERR_error_string(ERR_peek_last_error(), nullptr))
+
+// RFC 6962 section 2.1
+std::vector<std::byte>
+merkleTreeHash(EVP_MD const* md, std::byte const* data, std::size_t size, std::size_t leafSize)
+{
+	std::vector<std::byte> input;
+	if (size <= leafSize) {
+		input.push_back(std::byte{0x00});
+		input.insert(input.end(), data, data + size);
+	} else {
+		std::size_t k = leafSize;
+		while (2 * k < size)
+			k *= 2;
+		auto left = merkleTreeHash(md, data, k, leafSize);
+		auto right = merkleTreeHash(md, data + k, size - k, leafSize);
+		input.push_back(std::byte{0x01});
+		input.insert(input.end(), left.begin(), left.end());
+		input.insert(input.end(), right.begin(), right.end());
+	}
+	std::vector<std::byte> digest(EVP_MD_size(md));
+	Expect1(EVP_Digest(input.data(), input.size(), reinterpret_cast<unsigned char*>(digest.data()), nullptr, md, nullptr));
+	return digest;
+}
+
+void
+test(EVP_MD const* md, Security::WorkerPool& pool, std::size_t leafSize, std::size_t length, int maxChunkLength)
+{
+	std::vector<std::byte> data = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+	std::vector<std::byte> expected(EVP_MD_size(md));
+	if (length)
+		expected = merkleTreeHash(md, data.data(), data.size(), leafSize);
+	else
+		Expect1(EVP_Digest(nullptr, 0, reinterpret_cast<unsigned char*>(expected.data()), nullptr, md, nullptr));
+
+	assert(expected == Security::DigestTree::Compute(data.data(), data.size(), md, leafSize, pool));
+
+	Stream::Pipe pipe;
+	Security::DigestTreeOutput digestOutput{md, leafSize, pool};
+	pipe < digestOutput;
+	StreamTest::WriteRandomChunks(digestOutput, data,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	assert(expected == digestOutput.getOutputDigest());
+
+	std::vector<std::byte> read(data.size());
+	Security::DigestTreeInput digestInput{md, leafSize, pool};
+	pipe > digestInput;
+	StreamTest::ReadRandomChunks(digestInput, read,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	assert(read == data && expected == digestInput.getInputDigest());
+}
+
+int main()
+{
+	Security::WorkerPool pool{3};
+	std::size_t leafSize = 1000;
+	int maxChunkLength = 10000;
+
+	for (std::size_t length : {0, 1, 999, 1000, 1001, 2000, 4000, 5000, 13007, 1024*1024 + 13})
+		test(EVP_sha256(), pool, leafSize, length, maxChunkLength);
+	test(EVP_sha512(), Security::WorkerPool::Default(), 1024*1024, 8*1024*1024 + 5, 256*1024);
+	return 0;
+}
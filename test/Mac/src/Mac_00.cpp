@@ -0,0 +1,67 @@
+#include <Security/Mac.hpp>
+#include <Security/Digest.hpp>
+#include <StreamTest/Util.hpp>
+#include <cassert>
+#include <iostream>
+#include <openssl/err.h>
+#include <openssl/rand.h>
+
+#define Expect1(x) if (1 != x) throw std::runtime_error(ERR_error_string(ERR_peek_last_error(), nullptr))
+
+void
+test(std::string const& name, Security::Mac mac, EVP_MD const* md, Security::Key const& key, int count, int maxLength)
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	auto data = StreamTest::GetRandomBytes<std::chrono::nanoseconds>(static_cast<std::size_t>(count) * maxLength);
+	std::vector<int> lengths(count);
+	for (auto& length : lengths)
+		length = std::uniform_int_distribution<int>{0, maxLength}(gen);
+
+	std::vector<std::vector<std::byte>> expected(count);
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+		expected[i] = Security::Digest::Compute(data.data() + static_cast<std::size_t>(i) * maxLength, lengths[i], md, key);
+	auto digestTime = std::chrono::steady_clock::now() - start;
+
+	std::vector<std::byte> macs(count * mac.getSize());
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+		mac.compute(data.data() + static_cast<std::size_t>(i) * maxLength, lengths[i], macs.data() + i * mac.getSize());
+	auto macTime = std::chrono::steady_clock::now() - start;
+
+	Security::Mac copy{mac};
+	for (int i = 0; i < count; ++i) {
+		assert(expected[i].size() == mac.getSize());
+		assert(std::equal(expected[i].begin(), expected[i].end(), macs.begin() + i * mac.getSize()));
+		assert(copy.verify(data.data() + static_cast<std::size_t>(i) * maxLength, lengths[i], expected[i].data(), expected[i].size()));
+	}
+
+	// incremental
+	mac.init();
+	mac.update(data.data(), lengths[0] / 2);
+	mac.update(data.data() + lengths[0] / 2, lengths[0] - lengths[0] / 2);
+	std::vector<std::byte> incremental(mac.getSize());
+	assert(mac.final(incremental.data()) == mac.getSize() && incremental == expected[0]);
+
+	expected[0][0] ^= std::byte{1};
+	assert(!mac.verify(data.data(), lengths[0], expected[0].data(), expected[0].size()));
+
+	std::cout << name << " Digest::Compute: " << std::chrono::duration_cast<std::chrono::nanoseconds>(digestTime).count() / count
+			<< " ns/message, Mac::compute: " << std::chrono::duration_cast<std::chrono::nanoseconds>(macTime).count() / count
+			<< " ns/message" << std::endl;
+}
+
+int main()
+{
+	int count = 1024*16;
+
+	Security::Secret<> hKeyRaw(EVP_MD_size(EVP_sha256()));
+	Expect1(RAND_priv_bytes(hKeyRaw.get(), hKeyRaw.size()));
+	test("hmac-sha256", Security::Mac{EVP_sha256(), hKeyRaw}, EVP_sha256(), Security::Key{hKeyRaw}, count, 64);
+
+	Security::Secret<> cKeyRaw(EVP_CIPHER_key_length(EVP_aes_256_cbc()));
+	Expect1(RAND_priv_bytes(cKeyRaw.get(), cKeyRaw.size()));
+	test("cmac-aes-256-cbc", Security::Mac{EVP_aes_256_cbc(), cKeyRaw}, nullptr, Security::Key{cKeyRaw, EVP_aes_256_cbc()}, count, 64);
+	return 0;
+}
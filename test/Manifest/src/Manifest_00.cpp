@@ -0,0 +1,113 @@
+#include <Security/Manifest.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+void
+test(EVP_MD const* md, EVP_MD const* signMd, Security::Key const& key, std::uint32_t chunkSize, std::size_t length,
+		int maxChunkLength)
+{
+	std::vector<std::byte> data = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+
+	Stream::Pipe pipe;
+	Security::ManifestOutput manifestOutput{md, chunkSize};
+	pipe < manifestOutput;
+	StreamTest::WriteRandomChunks(manifestOutput, data,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	auto manifest = manifestOutput.getManifest();
+	assert(manifest.getDataSize() == length);
+	assert(manifest.getChunkCount() == (length + chunkSize - 1) / chunkSize);
+	manifest.sign(signMd, key);
+
+	// the manifest travels with its signature, chunks are checked once it is verified
+	Stream::Pipe manifestPipe;
+	manifestPipe << manifest;
+	Security::Manifest received{manifestPipe};
+	assert(received.verifySignature(signMd, key));
+	assert(received.getChunkSize() == chunkSize && received.getDataSize() == length);
+
+	std::vector<std::span<std::byte const>> chunks;
+	for (std::size_t offset = 0; offset < length; offset += chunkSize)
+		chunks.emplace_back(data.data() + offset, std::min<std::size_t>(chunkSize, length - offset));
+	auto verified = received.verifyChunks(0, chunks);
+	assert(std::all_of(verified.begin(), verified.end(), [](bool v) { return v; }));
+	for (std::size_t i = chunks.size(); i-- > 0;)
+		assert(received.verifyChunk(i, chunks[i].data(), chunks[i].size()));
+
+	auto computed = Security::Manifest::Compute(data.data(), data.size(), md, chunkSize);
+	computed.sign(signMd, key);
+	assert(computed.verifySignature(signMd, key));
+
+	std::vector<std::byte> read(data.size());
+	Security::ManifestInput manifestInput{received};
+	pipe > manifestInput;
+	StreamTest::ReadRandomChunks(manifestInput, read,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	assert(read == data);
+
+	if (length) {
+		std::vector<std::byte> tampered = data;
+		tampered[length / 2] ^= std::byte{1};
+		std::size_t index = length / 2 / chunkSize;
+		chunks[index] = {tampered.data() + index * chunkSize, chunks[index].size()};
+		verified = received.verifyChunks(0, chunks);
+		for (std::size_t i = 0; i < chunks.size(); ++i)
+			assert(verified[i] == (i != index));
+		assert(!received.verifyChunk(index + chunks.size(), chunks[index].data(), chunks[index].size()));
+
+		// the chunks before the modified one are released, no byte of it is
+		Security::ManifestInput tamperedInput{received};
+		pipe > tamperedInput;
+		pipe.write(tampered.data(), tampered.size());
+		tamperedInput.read(read.data(), index * chunkSize);
+		try {
+			tamperedInput.read(read.data(), 1);
+			assert(false);
+		} catch (Security::ManifestInput::Exception const& exc) {
+			assert(exc.code() == std::errc::bad_message);
+		}
+
+		// a source ending before the last chunk is not taken for the end of the data
+		Stream::Pipe truncatedPipe;
+		Security::ManifestInput truncatedInput{received};
+		truncatedPipe > truncatedInput;
+		truncatedPipe.write(data.data(), length - 1);
+		try {
+			truncatedInput.read(read.data(), length);
+			assert(false);
+		} catch (Security::ManifestInput::Exception const& exc) {
+			assert(exc.code() == std::errc::bad_message);
+		}
+
+		// the digests of a manifest with too many chunks are not allocated
+		Stream::Pipe limitPipe;
+		limitPipe << manifest;
+		try {
+			Security::Manifest{limitPipe, manifest.getChunkCount() - 1};
+			assert(false);
+		} catch (Security::Manifest::Exception const& exc) {
+			assert(exc.code() == std::errc::bad_message);
+		}
+
+		// another manifest does not verify with the signature
+		Security::Manifest other = Security::Manifest::Compute(tampered.data(), tampered.size(), md, chunkSize);
+		manifestPipe << other;
+		Security::Manifest forged{manifestPipe};
+		assert(!forged.verifySignature(signMd, key));
+	}
+
+	std::cout << EVP_MD_get0_name(md) << " " << chunkSize << ": " << manifest.getChunkCount() << " chunks" << std::endl;
+}
+
+int main()
+{
+	Security::Key ec{Security::Key::EC::prime256v1};
+	Security::Key ed{Security::Key::ED::ED25519};
+	test(EVP_sha256(), EVP_sha256(), ec, 64*1024, 1024*1024 + 123, 1024*16);
+	test(EVP_sha512(), nullptr, ed, 4*1024, 1024*100, 4096);
+	test(EVP_sha1(), EVP_sha256(), ec, 100, 0, 10);
+	test(EVP_sha256(), nullptr, ed, 128, 1000, 64);
+	return 0;
+}
@@ -0,0 +1,85 @@
+#include <Security/MultiDigest.hpp>
+#include <Security/Digest.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <cassert>
+#include <iostream>
+
+void
+test(std::vector<EVP_MD const*> const& mds, Security::WorkerPool* pool, std::size_t length, int minChunkLength, int maxChunkLength)
+{
+	std::vector<std::byte> data = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+
+	Stream::Pipe pipe;
+	Security::MultiDigestOutput digestOutput{mds, pool};
+	pipe < digestOutput;
+	StreamTest::WriteRandomChunks(digestOutput, data,
+			std::uniform_int_distribution<int> {minChunkLength, maxChunkLength});
+
+	std::vector<std::byte> read(data.size());
+	Security::MultiDigestInput digestInput{mds, pool};
+	pipe > digestInput;
+	StreamTest::ReadRandomChunks(digestInput, read,
+			std::uniform_int_distribution<int> {minChunkLength, maxChunkLength});
+	assert(read == data);
+
+	for (std::size_t i = 0; i < mds.size(); ++i) {
+		auto expected = Security::Digest::Compute(data.data(), data.size(), mds[i]);
+		assert(digestOutput.getOutputDigestSize(i) == expected.size());
+		assert(Security::Digest::Matches(expected, digestOutput.getOutputDigest(i)));
+		assert(Security::Digest::Matches(expected, digestInput.getInputDigest(i)));
+	}
+
+	// const getters are called concurrently
+	if (pool) {
+		pool->run(4 * mds.size(), [&](std::size_t i) {
+			auto expected = Security::Digest::Compute(data.data(), data.size(), mds[i % mds.size()]);
+			assert(Security::Digest::Matches(expected, digestOutput.getOutputDigest(i % mds.size())));
+		});
+	}
+}
+
+template <typename Duration = std::chrono::microseconds>
+void
+benchmark(std::vector<EVP_MD const*> const& mds, Security::WorkerPool* pool, std::size_t length, std::size_t chunkLength)
+{
+	std::vector<std::byte> data = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>> ctxs;
+	for (auto const* md : mds) {
+		ctxs.emplace_back(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+		EVP_DigestInit_ex(ctxs.back().get(), md, nullptr);
+	}
+	for (std::size_t offset = 0; offset < length; offset += chunkLength)
+		for (auto& ctx : ctxs)
+			EVP_DigestUpdate(ctx.get(), data.data() + offset, std::min(chunkLength, length - offset));
+	auto chainTime = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	Security::DigestSet digests{mds, pool};
+	unsigned long error;
+	for (std::size_t offset = 0; offset < length; offset += chunkLength)
+		if (!digests.update(data.data() + offset, std::min(chunkLength, length - offset), error))
+			assert(false);
+	auto setTime = std::chrono::steady_clock::now() - start;
+
+	std::cout << (pool ? "pool" : "single") << " chunk " << chunkLength
+			<< " separate: " << std::chrono::duration_cast<Duration>(chainTime).count()
+			<< " set: " << std::chrono::duration_cast<Duration>(setTime).count() << std::endl;
+}
+
+int main()
+{
+	Security::WorkerPool pool{3};
+	std::vector<EVP_MD const*> mds{EVP_md5(), EVP_sha1(), EVP_sha256()};
+
+	test(mds, nullptr, 1024*256 + 7, 1, 4096);
+	test(mds, &pool, 1024*1024 + 7, 1024*256, 1024*512);
+	test({EVP_sha512()}, &pool, 1024*64, 1, 1024);
+	test(mds, nullptr, 0, 1, 1);
+
+	benchmark(mds, nullptr, 1024*1024*4, 1024*1024);
+	benchmark(mds, &pool, 1024*1024*4, 1024*1024);
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include <Security/Cipher.hpp>
+#include <Security/ParallelCipher.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <openssl/rand.h>
+#include <cassert>
+#include <openssl/err.h>
+
+#define Expect1(x) if (1 != x) throw std::runtime_error(ERR_error_string(ERR_peek_last_error(), nullptr))
+
+std::vector<std::byte>
+readAll(Stream::Pipe& pipe, std::size_t size)
+{
+	std::vector<std::byte> data;
+	data.resize(size);
+	pipe.read(data.data(), data.size());
+	return data;
+}
+
+void
+test(EVP_CIPHER const* cipher, Security::WorkerPool& pool, std::size_t chunkSize, int length, int maxChunkLength)
+{
+	Security::Secret<> secretKey{static_cast<std::size_t>(EVP_CIPHER_key_length(cipher))};
+	Expect1(RAND_priv_bytes(secretKey.get(), secretKey.size()));
+	std::byte iv[EVP_MAX_IV_LENGTH];
+	Expect1(RAND_bytes(reinterpret_cast<unsigned char*>(iv), EVP_CIPHER_iv_length(cipher)));
+	std::memset(iv + 8, 0xFF, 8); // carry through the low 64 bits of the counter
+
+	std::vector<std::byte> plain = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+
+	Stream::Pipe serial;
+	{
+		Security::CipherEncrypt encryptor{cipher, secretKey, iv};
+		serial < encryptor;
+		encryptor.write(plain.data(), plain.size());
+	}
+
+	Stream::Pipe parallel;
+	{
+		Security::ParallelCipherEncrypt encryptor{cipher, secretKey, iv, pool, chunkSize};
+		parallel < encryptor;
+		StreamTest::WriteRandomChunks(encryptor, plain,
+				std::uniform_int_distribution<int> {1, maxChunkLength});
+		encryptor.flush();
+	}
+
+	auto encrypted = readAll(serial, plain.size());
+	assert(encrypted == readAll(parallel, plain.size()));
+
+	parallel.write(encrypted.data(), encrypted.size());
+	std::vector<std::byte> decrypted;
+	decrypted.resize(plain.size());
+	Security::ParallelCipherDecrypt decryptor{cipher, secretKey, iv, pool, chunkSize};
+	parallel > decryptor;
+	StreamTest::ReadRandomChunks(decryptor, decrypted,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	assert(decrypted == plain);
+
+	std::size_t offset = plain.size() / 3;
+	parallel.write(encrypted.data() + offset, encrypted.size() - offset);
+	decryptor.seek(offset);
+	decrypted.resize(plain.size() - offset);
+	decryptor.read(decrypted.data(), decrypted.size());
+	assert(std::equal(decrypted.begin(), decrypted.end(), plain.begin() + static_cast<std::ptrdiff_t>(offset)));
+}
+
+int main()
+{
+	Security::WorkerPool pool{4};
+	pool.run(0, [](std::size_t) { assert(false); });
+
+	int length = 1024*1024;
+	test(EVP_aes_128_ctr(), pool, 4096, length + 7, 256);
+	test(EVP_aes_128_ctr(), pool, 4099, length + 7, 64*1024);
+	test(EVP_aes_256_ctr(), pool, 64*1024, length, length);
+
+	return 0;
+}
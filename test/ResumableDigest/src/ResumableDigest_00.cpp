@@ -0,0 +1,72 @@
+#include <Security/ResumableDigest.hpp>
+#include <Security/Digest.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <cassert>
+
+void
+test(Security::DigestState::Algorithm algorithm, EVP_MD const* md, std::size_t length, int maxChunkLength)
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	std::vector<std::byte> data = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+	auto expected = Security::Digest::Compute(data.data(), data.size(), md);
+	std::size_t interrupted = std::uniform_int_distribution<std::size_t>{0, length}(gen);
+
+	// hash the first part, save the state
+	Stream::Pipe state;
+	{
+		Stream::Pipe pipe;
+		Security::ResumableDigestOutput digestOutput{Security::DigestState{algorithm}};
+		pipe < digestOutput;
+		StreamTest::WriteRandomChunks(digestOutput, std::vector<std::byte>(data.begin(), data.begin() + interrupted),
+				std::uniform_int_distribution<int> {1, maxChunkLength});
+		assert(digestOutput.getOutputState().getProcessedSize() == interrupted);
+		assert(Security::Digest::Matches(digestOutput.getOutputState().getDigest(),
+				Security::Digest::Compute(data.data(), interrupted, md)));
+		state << digestOutput.getOutputState();
+	}
+
+	// restore the state, hash the rest
+	Stream::Pipe pipe;
+	Security::ResumableDigestOutput digestOutput{Security::DigestState{state}};
+	pipe < digestOutput;
+	assert(digestOutput.getOutputState().getAlgorithm() == algorithm);
+	assert(digestOutput.getOutputState().getProcessedSize() == interrupted);
+	StreamTest::WriteRandomChunks(digestOutput, std::vector<std::byte>(data.begin() + interrupted, data.end()),
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	assert(Security::Digest::Matches(digestOutput.getOutputState().getDigest(), expected));
+
+	std::vector<std::byte> read(data.size() - interrupted);
+	Security::ResumableDigestInput initial{Security::DigestState{algorithm}};
+	Security::ResumableDigestInput digestInput{std::move(initial)};
+	assert(digestInput.getInputState().getAlgorithm() == algorithm);
+	pipe > digestInput;
+	StreamTest::ReadRandomChunks(digestInput, read,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	assert(Security::Digest::Matches(digestInput.getInputState().getDigest(),
+			Security::Digest::Compute(read.data(), read.size(), md)));
+}
+
+int main()
+{
+	for (int i = 0; i < 8; ++i) {
+		test(Security::DigestState::Algorithm::SHA1, EVP_sha1(), 1024*64 + i, 256);
+		test(Security::DigestState::Algorithm::SHA224, EVP_sha224(), 1024*64 + i, 256);
+		test(Security::DigestState::Algorithm::SHA256, EVP_sha256(), 1024*64 + i, 256);
+		test(Security::DigestState::Algorithm::SHA384, EVP_sha384(), 1024*64 + i, 256);
+		test(Security::DigestState::Algorithm::SHA512, EVP_sha512(), 1024*64 + i, 256);
+	}
+	test(Security::DigestState::Algorithm::SHA256, EVP_sha256(), 0, 1);
+
+	Stream::Pipe malformed;
+	std::uint8_t algorithm = 9;
+	malformed.write(&algorithm, 1);
+	try {
+		Security::DigestState state{malformed};
+		assert(false);
+	} catch (Security::DigestState::Exception const& exc) {
+		assert(exc.code() == std::errc::bad_message);
+	}
+	return 0;
+}
@@ -0,0 +1,164 @@
+#include <Security/Segment.hpp>
+#include <Stream/File.hpp>
+#include <Stream/Pipe.hpp>
+#include <StreamTest/Util.hpp>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cassert>
+#include <openssl/err.h>
+
+#define Expect1(x) if (1 != x) throw std::runtime_error(ERR_error_string(ERR_peek_last_error(), nullptr))
+
+std::vector<std::byte>
+testEncrypt(std::string const& fileName, EVP_CIPHER const* cipher, Security::Secret<> const& secretKey, std::uint32_t segmentSize, int length, int maxChunkLength)
+{
+	std::vector<std::byte> toEncrypt = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+
+	Stream::File file{fileName, Stream::File::Mode::W};
+	Stream::BufferOutput buffer{static_cast<std::size_t>(file.getBlockSize())};
+	Security::SegmentEncrypt encryptor{cipher, secretKey, segmentSize};
+	file < buffer < encryptor;
+
+	StreamTest::WriteRandomChunks(encryptor, toEncrypt,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	encryptor.finalizeEncryption();
+	return toEncrypt;
+}
+
+std::vector<std::byte>
+testDecrypt(std::string const& fileName, EVP_CIPHER const* cipher, Security::Secret<> const& secretKey, int length, int maxChunkLength)
+{
+	std::vector<std::byte> decrypted;
+	decrypted.resize(length);
+
+	Stream::File file{fileName, Stream::File::Mode::R};
+	Stream::BufferInput buffer{static_cast<std::size_t>(file.getBlockSize())};
+	Security::SegmentDecrypt decryptor{cipher, secretKey};
+	file > buffer > decryptor;
+
+	StreamTest::ReadRandomChunks(decryptor, decrypted,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	return decrypted;
+}
+
+std::vector<std::byte>
+readContainer(std::string const& fileName)
+{
+	Stream::File file{fileName, Stream::File::Mode::R};
+	std::vector<std::byte> container;
+	container.resize(file.getFileSize());
+	file.read(container.data(), container.size());
+	return container;
+}
+
+void
+testParallelDecrypt(std::vector<std::byte> const& container, EVP_CIPHER const* cipher, Security::Secret<> const& secretKey, std::vector<std::byte> const& expected)
+{
+	std::vector<std::byte> decrypted;
+	decrypted.resize(Security::Segment::PlainSize(cipher, container.data(), container.size()));
+	assert(decrypted.size() == expected.size());
+	Security::Segment::Decrypt(cipher, secretKey, container.data(), container.size(), decrypted.data());
+	assert(decrypted == expected);
+
+	Security::WorkerPool pool{3};
+	std::fill(decrypted.begin(), decrypted.end(), std::byte{});
+	Security::Segment::Decrypt(cipher, secretKey, container.data(), container.size(), decrypted.data(), pool);
+	assert(decrypted == expected);
+}
+
+void
+testSeek(std::vector<std::byte> const& container, EVP_CIPHER const* cipher, Security::Secret<> const& secretKey, std::uint32_t segmentSize, std::vector<std::byte> const& expected)
+{
+	std::uint32_t index = expected.size() / segmentSize / 2;
+	int headerSize = 4 + EVP_CIPHER_iv_length(cipher) - 5;
+
+	Stream::Pipe pipe;
+	pipe.write(container.data(), headerSize);
+
+	Security::SegmentDecrypt decryptor{cipher, secretKey};
+	pipe > decryptor;
+	auto offset = decryptor.seek(index);
+	pipe.write(container.data() + offset, container.size() - offset);
+
+	std::vector<std::byte> decrypted;
+	decrypted.resize(expected.size() - static_cast<std::size_t>(index) * segmentSize);
+	decryptor.read(decrypted.data(), decrypted.size());
+	assert(std::equal(decrypted.begin(), decrypted.end(), expected.begin() + static_cast<std::ptrdiff_t>(index) * segmentSize));
+}
+
+void
+testTamper(std::vector<std::byte> container, EVP_CIPHER const* cipher, Security::Secret<> const& secretKey, std::uint32_t segmentSize)
+{
+	int headerSize = 4 + EVP_CIPHER_iv_length(cipher) - 5;
+	container[headerSize] ^= std::byte{1};
+	std::vector<std::byte> decrypted;
+	decrypted.resize(container.size());
+	try {
+		Security::Segment::Decrypt(cipher, secretKey, container.data(), container.size(), decrypted.data());
+		assert(false);
+	} catch (Security::Segment::Exception const& exc) {
+		assert(exc.code() == std::make_error_code(std::errc::bad_message));
+	}
+	// the plaintext of the forged segment is wiped
+	assert(std::all_of(decrypted.begin(), decrypted.begin() + segmentSize, [](std::byte b) { return b == std::byte{}; }));
+
+	container[headerSize] ^= std::byte{1};
+	container.resize(container.size() - 1);
+	try {
+		Security::Segment::Decrypt(cipher, secretKey, container.data(), container.size(), decrypted.data());
+		assert(false);
+	} catch (Security::Segment::Exception const& exc) {
+		assert(exc.code() == std::make_error_code(std::errc::bad_message));
+	}
+}
+
+void
+testMaxSegmentSize(std::vector<std::byte> const& container, EVP_CIPHER const* cipher, Security::Secret<> const& secretKey, std::uint32_t segmentSize)
+{
+	Stream::Pipe pipe;
+	pipe.write(container.data(), container.size());
+
+	Security::SegmentDecrypt decryptor{cipher, secretKey, segmentSize - 1};
+	pipe > decryptor;
+	std::byte byte;
+	try {
+		decryptor.read(&byte, 1);
+		assert(false);
+	} catch (Security::SegmentDecrypt::Exception const& exc) {
+		assert(exc.code() == std::make_error_code(std::errc::bad_message));
+	}
+}
+
+void
+test(std::string const& fileName, EVP_CIPHER const* cipher, std::uint32_t segmentSize, int length, int maxChunkLength)
+{
+	Security::Secret<> secretKey{static_cast<std::size_t>(EVP_CIPHER_key_length(cipher))};
+	Expect1(RAND_priv_bytes(secretKey.get(), secretKey.size()));
+
+	auto encrypt = testEncrypt(fileName, cipher, secretKey, segmentSize, length, maxChunkLength);
+	auto decrypt = testDecrypt(fileName, cipher, secretKey, length, maxChunkLength);
+	assert(encrypt == decrypt);
+
+	auto container = readContainer(fileName);
+	testParallelDecrypt(container, cipher, secretKey, encrypt);
+	testSeek(container, cipher, secretKey, segmentSize, encrypt);
+	testTamper(container, cipher, secretKey, segmentSize);
+	testMaxSegmentSize(container, cipher, secretKey, segmentSize);
+}
+
+int main()
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+
+	int length = 1024*64;
+	int maxChunkLength = 256;
+
+	test("gcm.seg", EVP_aes_256_gcm(), 4096, length, maxChunkLength);
+	test("gcm_aligned.seg", EVP_aes_128_gcm(), 1024, length, maxChunkLength);
+
+	length += std::uniform_int_distribution<int>{1, 4096}(gen);
+	test("chacha20poly1305.seg", EVP_chacha20_poly1305(), 4096, length, maxChunkLength);
+
+	return 0;
+}
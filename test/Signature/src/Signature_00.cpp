@@ -65,6 +65,51 @@ test(std::string const& fileName, EVP_MD const* md, Security::Key const& key, in
 	testInput(fileName, md, pubkey, signature2, length, maxChunkLength);
 }
 
+void
+testOneShotKey(EVP_MD const* md, Security::Key const& key, int length, int maxChunkLength)
+{
+	std::vector<std::byte> data = StreamTest::GetRandomBytes<std::chrono::hours>(length);
+
+	Stream::Pipe pipe;
+	Security::SignatureOutput signatureOutput(md, Security::PrivateKey(key));
+	pipe < signatureOutput;
+	StreamTest::WriteRandomChunks(signatureOutput, data,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	auto signature = signatureOutput.getSignature();
+	assert(signature.size() <= signatureOutput.getSignatureSize());
+
+	std::vector<std::byte> read(length);
+	Security::SignatureInput signatureInput(md, Security::PublicKey(key));
+	pipe > signatureInput;
+	StreamTest::ReadRandomChunks(signatureInput, read,
+			std::uniform_int_distribution<int> {1, maxChunkLength});
+	assert(signatureInput.verifySignature(signature));
+
+	// the observers sign a digest of the data, the statics the data itself
+	auto direct = Security::Signature::Sign(data.data(), data.size(), nullptr, key);
+	assert(Security::Signature::Verify(data.data(), data.size(), nullptr, key, direct));
+	assert(!signatureInput.verifySignature(direct));
+
+	data[0] ^= std::byte{1};
+	pipe.write(data.data(), data.size());
+	Security::SignatureInput tampered(md, Security::PublicKey(key));
+	pipe > tampered;
+	tampered.read(read.data(), read.size());
+	assert(!tampered.verifySignature(signature));
+
+	// a fetched digest names itself differently than the legacy one, the prehash does not depend on it
+	if (!md) {
+		std::unique_ptr<EVP_MD, decltype(&EVP_MD_free)> fetched{EVP_MD_fetch(nullptr, "SHA2-512", nullptr), EVP_MD_free};
+		assert(fetched);
+		data[0] ^= std::byte{1};
+		pipe.write(data.data(), data.size());
+		Security::SignatureInput fetchedInput(fetched.get(), Security::PublicKey(key));
+		pipe > fetchedInput;
+		fetchedInput.read(read.data(), read.size());
+		assert(fetchedInput.verifySignature(signature));
+	}
+}
+
 int main() {
 	std::random_device rd;
 	std::mt19937 gen(rd());
@@ -93,5 +138,8 @@ int main() {
 	test("sha256dsa", EVP_sha256(), dsaKey, length, maxChunkLength);
 	test("sha256rsa", EVP_sha256(), rsaKey, length, maxChunkLength);
 
+	testOneShotKey(nullptr, Security::Key(Security::Key::ED::ED25519), length, maxChunkLength);
+	testOneShotKey(EVP_sha256(), Security::Key(Security::Key::ED::ED448), length, maxChunkLength);
+
 	return 0;
 }
@@ -0,0 +1,62 @@
+#include <Security/Signature.hpp>
+#include <StreamTest/Util.hpp>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+
+void
+test(std::string const& name, EVP_MD const* md, std::vector<Security::Key> const& keys, Security::WorkerPool& pool,
+		int count, int maxLength)
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	auto data = StreamTest::GetRandomBytes<std::chrono::nanoseconds>(static_cast<std::size_t>(count) * maxLength);
+
+	std::vector<std::vector<std::byte>> signatures(count);
+	std::vector<Security::Signature::Job> jobs(count);
+	std::vector<bool> expected(count);
+	for (int i = 0; i < count; ++i) {
+		auto const& key = keys[i % keys.size()];
+		auto& job = jobs[i];
+		job.data = data.data() + static_cast<std::size_t>(i) * maxLength;
+		job.count = std::uniform_int_distribution<int>{0, maxLength}(gen);
+		job.verifyKey = &key;
+		signatures[i] = Security::Signature::Sign(job.data, job.count, md, key);
+		expected[i] = std::uniform_int_distribution<int>{0, 3}(gen);
+		if (!expected[i]) {
+			if (i % 2)
+				signatures[i][signatures[i].size() / 2] ^= std::byte{1};
+			else
+				signatures[i].resize(signatures[i].size() / 2);
+		}
+		job.signature = signatures[i].data();
+		job.signatureSize = signatures[i].size();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i) {
+		assert(expected[i] == Security::Signature::Verify(jobs[i].data, jobs[i].count, md, *jobs[i].verifyKey, signatures[i]));
+	}
+	auto singleTime = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	auto verified = Security::Signature::Verify(jobs, md, pool);
+	auto batchTime = std::chrono::steady_clock::now() - start;
+
+	assert(verified == expected);
+	assert(Security::Signature::Verify(std::span<Security::Signature::Job const>{}, md, pool).empty());
+	std::cout << name << " single: " << std::chrono::duration_cast<std::chrono::microseconds>(singleTime).count() / count
+			<< " us/signature, batch: " << std::chrono::duration_cast<std::chrono::microseconds>(batchTime).count() / count
+			<< " us/signature" << std::endl;
+}
+
+int main()
+{
+	Security::WorkerPool pool;
+	int count = 1000;
+
+	test("ed25519", nullptr, {Security::Key{Security::Key::ED::ED25519}, Security::Key{Security::Key::ED::ED25519}}, pool, count, 256);
+	test("ed448", nullptr, {Security::Key{Security::Key::ED::ED448}}, pool, count / 4, 256);
+	test("sha256ec", EVP_sha256(), {Security::Key{Security::Key::EC::prime256v1}, Security::Key{Security::Key::EC::secp384r1}}, pool, count, 256);
+	return 0;
+}
@@ -0,0 +1,77 @@
+#include <Security/Signer.hpp>
+#include <StreamTest/Util.hpp>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <openssl/err.h>
+
+void
+test(std::string const& name, EVP_MD const* md, Security::Key const& key, int count, int maxLength)
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	auto data = StreamTest::GetRandomBytes<std::chrono::nanoseconds>(static_cast<std::size_t>(count) * maxLength);
+	std::vector<int> lengths(count);
+	for (auto& length : lengths)
+		length = std::uniform_int_distribution<int>{0, maxLength}(gen);
+
+	Security::Signer signer{md, key};
+	Security::Verifier verifier{md, key};
+
+	std::vector<std::vector<std::byte>> signatures(count);
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+		signatures[i] = signer.sign(data.data() + static_cast<std::size_t>(i) * maxLength, lengths[i]);
+	auto signTime = std::chrono::steady_clock::now() - start;
+
+	// both paths are warmed up, the first verifications with a key are slower
+	assert(verifier.verify(data.data(), lengths[0], signatures[0]));
+	assert(Security::Signature::Verify(data.data(), lengths[0], md, key, signatures[0]));
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+		assert(verifier.verify(data.data() + static_cast<std::size_t>(i) * maxLength, lengths[i], signatures[i]));
+	auto verifyTime = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i)
+		assert(Security::Signature::Verify(data.data() + static_cast<std::size_t>(i) * maxLength, lengths[i], md, key, signatures[i]));
+	auto signatureVerifyTime = std::chrono::steady_clock::now() - start;
+
+	// copies on other threads
+	std::thread thread([&] {
+		thread_local Security::Signer threadSigner{signer};
+		thread_local Security::Verifier threadVerifier{verifier};
+		auto signature = threadSigner.sign(data.data(), lengths[0]);
+		assert(threadVerifier.verify(data.data(), lengths[0], signature));
+	});
+	thread.join();
+
+	signatures[0][signatures[0].size() / 2] ^= std::byte{1};
+	assert(!verifier.verify(data.data(), lengths[0], signatures[0]));
+	assert(!verifier.verify(data.data(), lengths[0], signatures[0].data(), signatures[0].size() / 2));
+	assert(verifier.verify(data.data() + maxLength, lengths[1], signatures[1]));
+
+	// malformed signatures are rejected the same way by both paths, the error queue of the caller is kept
+	ERR_raise(ERR_LIB_USER, ERR_R_PASSED_INVALID_ARGUMENT);
+	unsigned long callerError = ERR_peek_last_error();
+	auto truncated = signatures[1];
+	truncated.resize(truncated.size() / 2);
+	assert(!verifier.verify(data.data() + maxLength, lengths[1], truncated));
+	assert(!Security::Signature::Verify(data.data() + maxLength, lengths[1], md, key, truncated));
+	assert(ERR_peek_last_error() == callerError);
+	ERR_clear_error();
+
+	std::cout << name << " sign: " << std::chrono::duration_cast<std::chrono::microseconds>(signTime).count() / count
+			<< " us, verify: " << std::chrono::duration_cast<std::chrono::microseconds>(verifyTime).count() / count
+			<< " us, Signature::Verify: " << std::chrono::duration_cast<std::chrono::microseconds>(signatureVerifyTime).count() / count
+			<< " us" << std::endl;
+}
+
+int main()
+{
+	test("sha256ec", EVP_sha256(), Security::Key{Security::Key::EC::prime256v1}, 500, 256);
+	test("sha256rsa", EVP_sha256(), Security::Key{Security::Key::RSA::RSA3072}, 50, 256);
+	test("ed25519", nullptr, Security::Key{Security::Key::ED::ED25519}, 500, 256);
+	return 0;
+}
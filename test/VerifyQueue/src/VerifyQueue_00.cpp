@@ -0,0 +1,54 @@
+#include <Security/VerifyQueue.hpp>
+#include <StreamTest/Util.hpp>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+
+void
+test(std::string const& name, EVP_MD const* md, Security::Key const& key, int count, int maxLength)
+{
+	auto data = StreamTest::GetRandomBytes<std::chrono::nanoseconds>(static_cast<std::size_t>(count) * maxLength);
+	std::vector<std::vector<std::byte>> signatures(count);
+	std::vector<Security::Signature::Job> jobs(count);
+	for (int i = 0; i < count; ++i) {
+		auto const* message = data.data() + static_cast<std::size_t>(i) * maxLength;
+		signatures[i] = Security::Signature::Sign(message, maxLength, md, key);
+		if (i % 3 == 0) // tampered
+			signatures[i][signatures[i].size() / 2] ^= std::byte{1};
+		jobs[i] = {message, static_cast<std::size_t>(maxLength), &key, signatures[i].data(), signatures[i].size()};
+	}
+
+	Security::WorkerPool pool{4};
+	Security::VerifyQueue queue{md, pool, 16};
+
+	std::vector<std::future<bool>> futures;
+	futures.reserve(count);
+	for (auto const& job : jobs)
+		futures.push_back(queue.submit(job));
+	for (int i = 0; i < count; ++i)
+		assert(futures[i].get() == (i % 3 != 0));
+
+	std::vector<std::atomic<int>> results(count);
+	for (int i = 0; i < count; ++i)
+		queue.submit(jobs[i], [&results, i](bool verified) { results[i] = verified ? 1 : 2; });
+	queue.wait();
+	for (int i = 0; i < count; ++i)
+		assert(results[i] == (i % 3 != 0 ? 1 : 2));
+
+	auto statistics = queue.getStatistics();
+	assert(statistics.completed == static_cast<std::uint64_t>(count) * 2);
+	assert(!statistics.depth && !statistics.active && !queue.getDepth());
+	assert(statistics.maxLatency >= statistics.maxWait);
+
+	std::cout << name << ": " << std::chrono::duration_cast<std::chrono::microseconds>(statistics.totalLatency).count() / statistics.completed
+			<< " us mean latency, " << std::chrono::duration_cast<std::chrono::microseconds>(statistics.maxWait).count()
+			<< " us max wait" << std::endl;
+}
+
+int main()
+{
+	test("sha256ec", EVP_sha256(), Security::Key{Security::Key::EC::prime256v1}, 300, 256);
+	test("sha256rsa", EVP_sha256(), Security::Key{Security::Key::RSA::RSA3072}, 60, 256);
+	test("ed25519", nullptr, Security::Key{Security::Key::ED::ED25519}, 300, 256);
+	return 0;
+}
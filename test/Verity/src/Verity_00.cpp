@@ -0,0 +1,116 @@
+#include <Security/Verity.hpp>
+#include <Security/DigestTree.hpp>
+#include <Stream/File.hpp>
+#include <StreamTest/Util.hpp>
+#include <algorithm>
+#include <cassert>
+
+void
+writeFile(std::string const& fileName, std::vector<std::byte> const& data)
+{
+	Stream::File file(fileName, Stream::File::Mode::W);
+	file.write(data.data(), data.size());
+}
+
+void
+expectBadMessage(auto&& f)
+{
+	try {
+		f();
+		assert(false);
+	} catch (std::system_error const& exc) {
+		assert(exc.code() == std::errc::bad_message);
+	}
+}
+
+void
+test(EVP_MD const* md, std::size_t blockSize, std::size_t length, std::size_t cacheSize)
+{
+	std::random_device rd;
+	std::mt19937 gen(rd());
+	std::vector<std::byte> data = StreamTest::GetRandomBytes<std::chrono::minutes>(length);
+	writeFile("verity.data", data);
+
+	auto root = Security::Verity::Build(md, "verity.data", "verity.tree", blockSize);
+	assert(root == Security::DigestTree::Compute(data.data(), data.size(), md, blockSize));
+
+	Security::VerityInput input{md, "verity.data", "verity.tree", root, cacheSize};
+	assert(input.getSize() == length);
+	for (int i = 0; i < 64 && length; ++i) {
+		std::size_t offset = std::uniform_int_distribution<std::size_t>{0, length - 1}(gen);
+		std::size_t size = std::uniform_int_distribution<std::size_t>{1, std::min<std::size_t>(length - offset, blockSize * 3)}(gen);
+		std::vector<std::byte> read(size);
+		input.setPosition(offset);
+		input.read(read.data(), size);
+		assert(std::equal(read.begin(), read.end(), data.begin() + static_cast<std::ptrdiff_t>(offset)));
+		assert(input.getPosition() == offset + size);
+	}
+	input.setPosition(0);
+	std::vector<std::byte> read(length);
+	input.read(read.data(), length);
+	assert(read == data);
+	try {
+		std::byte b;
+		input.read(&b, 1);
+		assert(false);
+	} catch (Security::VerityInput::Exception const& exc) {
+		assert(exc.code() == std::errc::no_message_available);
+	}
+
+	if (!length)
+		return;
+
+	// a modified block fails, the other blocks can still be read
+	std::size_t modified = std::uniform_int_distribution<std::size_t>{0, length - 1}(gen);
+	data[modified] ^= std::byte{1};
+	writeFile("verity.data", data);
+	Security::VerityInput tampered{md, "verity.data", "verity.tree", root, cacheSize};
+	tampered.setPosition(modified);
+	expectBadMessage([&] { std::byte b; tampered.read(&b, 1); });
+	std::size_t other = (modified / blockSize + 1) * blockSize;
+	if (other < length) {
+		tampered.setPosition(other);
+		std::byte b;
+		tampered.read(&b, 1);
+		assert(b == data[other]);
+	}
+
+	// a wrong root fails
+	data[modified] ^= std::byte{1};
+	writeFile("verity.data", data);
+	root[0] ^= std::byte{1};
+	Security::VerityInput wrongRoot{md, "verity.data", "verity.tree", root, cacheSize};
+	expectBadMessage([&] { std::byte b; wrongRoot.read(&b, 1); });
+}
+
+int main()
+{
+	test(EVP_sha256(), 4096, 1024*1024 + 13, 64*1024);
+	test(EVP_sha256(), 4096, 1024*1024, 4);
+	test(EVP_sha512(), 1024, 5 * 1024 + 1, 64);
+	test(EVP_sha256(), 4096, 100, 64);
+	test(EVP_sha256(), 4096, 0, 64);
+
+	expectBadMessage([] {
+		writeFile("verity.data", StreamTest::GetRandomBytes<std::chrono::minutes>(4096));
+		auto root = Security::Verity::Build(EVP_sha256(), "verity.data", "verity.tree");
+		writeFile("verity.data", StreamTest::GetRandomBytes<std::chrono::minutes>(4097));
+		Security::VerityInput input{EVP_sha256(), "verity.data", "verity.tree", root};
+	});
+
+	// a forged block size is rejected before a block is allocated, the tree still matches one block
+	expectBadMessage([] {
+		writeFile("verity.data", StreamTest::GetRandomBytes<std::chrono::minutes>(100));
+		auto root = Security::Verity::Build(EVP_sha256(), "verity.data", "verity.tree");
+		std::vector<std::byte> tree;
+		{
+			Stream::File file{"verity.tree", Stream::File::Mode::R};
+			tree.resize(file.getFileSize());
+			file.read(tree.data(), tree.size());
+		}
+		std::fill(tree.begin(), tree.begin() + 4, std::byte{0xff});
+		writeFile("verity.tree", tree);
+		Security::VerityInput input{EVP_sha256(), "verity.data", "verity.tree", root};
+	});
+	return 0;
+}